@@ -107,163 +107,198 @@
 
 
 /* hybrid_dumper.cpp  --------------------------------------------------------
- * 1. Waits for 0xA5 0x5A, reads LEN, ID, payload, CRC
- * 2. If ID matches one of your known packet IDs it copies the payload into
- *    the matching struct and prints the fields by name.
+ * 1. Sleeps until the port has bytes, reads them in big batches and hands
+ *    them to the firmware's own parser (avionics_stack SerialProtocol.hpp):
+ *    0xA5 0x5A, LEN, ID, payload, CRC, with the same MaxPayload and CRC as
+ *    the ESP. Corrupted frames are flagged ("!! corrupted"), never printed.
+ * 2. If ID matches one of your known packet IDs it prints the fields by
+ *    name, straight from the generated field tables (packet_fields.hpp),
+ *    as text, CSV or JSON lines (packet_format.hpp).
  * 3. Otherwise it just hex-dumps the bytes.
  *
- * Build  (Linux/macOS):
- *     g++ -std=c++17 -I. hybrid_dumper.cpp -o hybrid_dumper
- *     sudo ./hybrid_dumper /dev/ttyUSB0 115200
+ * Reading and printing are two threads joined by a lock-free frame ring
+ * (frame_pipeline.hpp): a stalled terminal or pipe only fills the ring,
+ * the port is still read at line rate.
  *
- * Build  (Windows, MSVC):
- *     cl /EHsc /std:c++17 hybrid_dumper.cpp
- *     hybrid_dumper COM3 115200
+ * Build  (Linux/macOS):
+ *     g++ -std=c++17 -O2 -pthread -I. -Ihost -I../avionics_stack/lib/SerialProtocol \
+ *         -I../avionics_stack/lib/Packets hybrid_dumper.cpp -o hybrid_dumper
+ *     sudo ./hybrid_dumper /dev/ttyUSB0 115200 [text|csv|json]
  * -------------------------------------------------------------------------*/
-#include <fcntl.h>
-#include <termios.h>
-#include <unistd.h>
-
+#include <atomic>
+#include <csignal>
 #include <cstdint>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 #include <string>
-#include <vector>
 #include <chrono>
+#include <thread>
 
-// ─────── your packet IDs & structs ───────
-#include "packet_id.hpp"          // e.g. MassDrill_ID, DustData_ID, …
-#include "packet_definition.hpp"  // e.g. MassPacket, DustData, …
+// ─────── your packet IDs & structs, the firmware's own (avionics_stack/lib/Packets) ───────
+#include <packet_id.hpp>          // e.g. MassDrill_ID, DustData_ID, …
+#include <packet_definition.hpp>  // e.g. MassPacket, DustData, …
+#include <packet_fields.hpp>      // generated field tables, e.g. MassPacket_desc
 
-// ─────── open & configure serial port ─────
-int openSerial(const std::string& dev, int baud)
-{
-    int fd = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_SYNC);
-    if (fd < 0) { perror(dev.c_str()); return -1; }
-
-    termios tty{};
-    if (tcgetattr(fd, &tty) != 0) { perror("tcgetattr"); ::close(fd); return -1; }
-    cfmakeraw(&tty);
-
-    speed_t spd = (baud == 115200) ? B115200 :
-                  (baud == 57600)  ? B57600  :
-                  (baud == 38400)  ? B38400  :
-                  (baud == 19200)  ? B19200  : B9600;
-    cfsetispeed(&tty, spd);
-    cfsetospeed(&tty, spd);
-    tty.c_cflag |= (CLOCAL | CREAD);
-    if (tcsetattr(fd, TCSANOW, &tty) != 0) { perror("tcsetattr"); ::close(fd); return -1; }
-
-    return fd;
-}
+// ─────── non-blocking port, batched reads ───────
+#include "serial_io.hpp"
 
-// ─────── min-hex helper ───────
-inline void hx(uint8_t b)
-{
-    std::cout << std::hex << std::uppercase << std::setw(2)
-              << std::setfill('0') << unsigned(b) << std::dec;
-}
+// ─────── table-driven text / CSV / JSON lines ───────
+#include "packet_format.hpp"
 
-// ─────── memcpy payload → struct safely ───────
-template<typename T>
-bool as(const std::vector<uint8_t>& pl, T& out)
-{
-    if (pl.size() != sizeof(T)) return false;
-    std::memcpy(&out, pl.data(), sizeof(T));
-    return true;
-}
+// ─────── reader thread -> frame ring -> writer thread ───────
+#include "frame_pipeline.hpp"
 
-// ─────── pretty-printers for your structs ───────
-void show(const MassPacket& m)
-{
-    std::cout << "MassPacket { id=" << unsigned(m.id)
-              << ", mass=" << m.mass
-              << ", tare=" << m.tare << " }\n";
-}
-void show(const DustData& d)
+// ─────── the ESP's parser, compiled as is (host/Arduino.h shim) ───────
+#include <SerialProtocol.hpp>
+
+constexpr size_t kMaxPayload = 128;       // same as TransportMux<128> in avionics_stack/lib/Nexus/Nexus.cpp
+using Parser = SerialProtocol<kMaxPayload>;
+using Frame  = Parser::Frame;
+using Slot   = StampedFrame<Frame>;
+
+constexpr size_t kRingDepth = 1 << 16;    // ~10 MB, a minute of a saturated 115200 link
+constexpr size_t kFlushBytes = 1 << 18;   // write() at least this often while the ring is busy
+
+static FrameQueue<Slot, kRingDepth> ring;
+
+// ─────── which packet each frame ID carries ───────
+void registerPackets(PacketFormatter& fmt)
 {
-    std::cout << "DustData { pm1_0_std=" << d.pm1_0_std
-              << ", pm2_5_std=" << d.pm2_5_std
-              << ", pm10_std="  << d.pm10_std
-              << " … }\n";   // shorten for terminal
+    // telemetry, ESP -> host
+    fmt.add(MassDrill_ID,         MassPacket_desc);
+    fmt.add(MassHD_ID,            MassPacket_desc);
+    fmt.add(DustData_ID,          DustData_desc);
+    fmt.add(FourInOne_ID,         FourInOne_desc);
+    fmt.add(Heartbeat_ID,         Heartbeat_desc);
+    fmt.add(LinkStats_ID,         LinkStats_desc);
+    // commands, host -> ESP (when sniffing that direction)
+    fmt.add(ServoCam_ID,          ServoRequest_desc);
+    fmt.add(ServoDrill_ID,        ServoRequest_desc);
+    fmt.add(MassDrill_Request_ID, MassRequestDrill_desc);
+    fmt.add(MassHD_Request_ID,    MassRequestHD_desc);
+    fmt.add(LED0_ID,              LEDMessage_desc);
+    fmt.add(LED1_ID,              LEDMessage_desc);
+    // add one line here per new ID, the fields come from the .msg
+
+    // counters only go up: print how fast they go too (against the ESP's own clock)
+    fmt.addRates(LinkStats_ID,    "uptime_ms");
 }
-void show(const ServoResponse& s)
+
+// ─────── writer thread: ring -> lines -> stdout ───────
+void writerLoop(PacketFormatter& fmt, Doorbell& bell, SerialReader& reader, std::atomic<bool>& outputGone)
 {
-    std::cout << "ServoResponse { id=" << unsigned(s.id)
-              << ", angle=" << s.angle
-              << ", success=" << s.success << " }\n";
+    std::string out;            // lines waiting for the next write()
+    out.reserve(2 * kFlushBytes);
+    uint32_t dropped = 0;
+    double ts = 0;
+
+    auto flush = [&]() {
+        if (!out.empty() && !writeAll(STDOUT_FILENO, out.data(), out.size())) {
+            outputGone = true;
+            reader.wake();          // the reader may be asleep on a quiet port, don't wait for its next byte
+        }
+        out.clear();
+    };
+
+    bool open = true;
+    while (open && !outputGone) {
+        open = bell.wait();
+        while (const Slot* s = ring.front()) {
+            ts = s->ts;
+            if (s->corrupted) {
+                fmt.corrupted(ts, s->badCrc, s->badLength, out);
+            } else if (s->id == kSuperframeId) {        // one line per record
+                forEachRecord(s->payload.data(), s->length, [&](uint8_t rid, const uint8_t* p, uint8_t len) {
+                    fmt.packet(ts, rid, p, len, out);
+                });
+            } else {
+                fmt.packet(ts, s->id, s->payload.data(), s->length, out);
+            }
+            ring.release();
+            if (out.size() >= kFlushBytes) flush();
+        }
+        // The reader only drops the newest frames, so they belong after what was just printed
+        if (ring.dropped() != dropped) {
+            fmt.dropped(ts, ring.dropped() - dropped, out);
+            dropped = ring.dropped();
+        }
+        flush();
+    }
 }
-// add more show() overloads here as you define new packets
 
 // ───────────────────────── main ──────────────────────────────
 int main(int argc, char* argv[])
 {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <serial-port> <baud>\n";
+    OutFormat format = OutFormat::Text;
+    if (argc < 3 || argc > 4 || (argc == 4 && !parseFormat(argv[3], format))) {
+        std::cerr << "Usage: " << argv[0] << " <serial-port> <baud> [text|csv|json]\n";
         return 1;
     }
+    std::signal(SIGPIPE, SIG_IGN);   // stdout closed (| head): write() fails with EPIPE, we exit cleanly
     int fd = openSerial(argv[1], std::stoi(argv[2]));
     if (fd < 0) return 1;
 
-    enum State { STX1, STX2, LEN_LO, LEN_HI, FRAME } st = STX1;
-    uint16_t len = 0;
-    std::vector<uint8_t> frame;   // ID + payload + CRC
-
-    while (true) {
-        uint8_t byte;
-        if (::read(fd, &byte, 1) != 1) continue;
-
-        switch (st) {
-            case STX1:  if (byte == 0xA5) st = STX2; break;
-            case STX2:
-                if (byte == 0x5A) st = LEN_LO;
-                else if (byte != 0xA5) st = STX1;
-                break;
-            case LEN_LO: len = byte; st = LEN_HI; break;
-            case LEN_HI:
-                len |= static_cast<uint16_t>(byte) << 8;
-                if (len == 0 || len > 1024) { st = STX1; break; }  // sanity
-                frame.clear(); frame.reserve(len + 2); st = FRAME;
-                break;
-            case FRAME:
-                frame.push_back(byte);
-                if (frame.size() == len + 2) {         // full frame (ID+payload+CRC)
-                    uint8_t id = frame[0];
-                    std::vector<uint8_t> payload(frame.begin()+1, frame.begin()+len);
-                    // -------- timestamp ----------
-                    double ts = std::chrono::duration<double>(
-                        std::chrono::system_clock::now().time_since_epoch()).count();
-                    std::cout << std::fixed << std::setprecision(3)
-                              << ts << "  id=0x"; hx(id); std::cout << ' ';
-                    // -------- decode or dump -----
-                    bool printed = false;
-                    switch (id) {
-                        case MassDrill_ID:
-                        case MassHD_ID: {
-                            MassPacket mp; if (as(payload, mp)) { show(mp); printed = true; }
-                            break;
-                        }
-                        case DustData_ID: {
-                            DustData dd; if (as(payload, dd)) { show(dd); printed = true; }
-                            break;
-                        }
-                        case ServoResponse_ID: {
-                            ServoResponse sr; if (as(payload, sr)) { show(sr); printed = true; }
-                            break;
-                        }
-                        // add more cases here …
-                    }
-                    if (!printed) {
-                        std::cout << "len=" << payload.size() << " payload=";
-                        for (auto b : payload) { hx(b); std::cout << ' '; }
-                        // CRC (two bytes) — still print them for debugging
-                        std::cout << "crc="; hx(frame[len]); std::cout << ' '; hx(frame[len+1]);
-                        std::cout << '\n';
-                    }
-                    st = STX1;
-                }
-                break;
+    FdStream port(fd);
+    Parser parser(port);
+    parser.setResync(true);     // a corrupted header never hides the good frames right behind it
+    SerialReader reader(fd);
+
+    PacketFormatter fmt(format);
+    registerPackets(fmt);
+
+    Doorbell bell;
+    std::atomic<bool> outputGone{false};
+    std::thread writer(writerLoop, std::ref(fmt), std::ref(bell), std::ref(reader), std::ref(outputGone));
+
+    auto now = []() {
+        return std::chrono::duration<double>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    };
+
+    // The parser drops bad frames and only counts them, queue a marker for the
+    // new ones before the next good frame so they show up where they happened
+    ProtocolStats seen{};
+    double ts = 0;
+    auto flagCorrupted = [&]() {
+        const ProtocolStats& st = parser.stats();
+        if (st.crcFailures == seen.crcFailures && st.lengthRejects == seen.lengthRejects) return;
+        if (Slot* s = ring.back()) {
+            s->ts = ts;
+            s->corrupted = true;
+            s->badCrc = st.crcFailures - seen.crcFailures;
+            s->badLength = st.lengthRejects - seen.lengthRejects;
+            ring.commit();
         }
+        seen = st;
+    };
+
+    // Reader side: copy the frame into the ring and go on, never wait for the output
+    auto onFrame = [&](const Frame& f) {
+        flagCorrupted();
+        Slot* s = ring.back();
+        if (!s) return;                         // ring full, counted in ring.dropped()
+        s->id = f.id;
+        s->length = f.length;
+        std::memcpy(s->payload.data(), f.payload.data(), f.length);
+        s->ts = ts;
+        s->corrupted = false;
+        ring.commit();
+    };
+
+    while (!outputGone && reader.pump([&](const uint8_t* data, size_t n) {
+        ts = now();                             // one timestamp per batch
+        parser.processBytes(data, n, onFrame);
+        flagCorrupted();
+    })) {
+        bell.ring();
     }
+
+    bell.close();
+    writer.join();
+    const ProtocolStats& st = parser.stats();
+    std::cerr << argv[1] << ": port closed (" << st.framesOk << " frames ok, " << st.crcFailures
+              << " bad CRC, " << st.lengthRejects << " bad length, " << ring.dropped()
+              << " dropped by a slow output, " << st.bytesIn << " bytes in " << reader.reads() << " reads)\n";
+    ::close(fd);
+    return 0;
 }
@@ -0,0 +1,90 @@
+/* frame_pipeline.hpp  -------------------------------------------------------
+ * Reading the port and printing the frames in two threads, so a slow
+ * terminal or a stalled pipe never keeps the port from being drained:
+ *
+ *   reader (main thread)   SerialReader -> SerialProtocol -> FrameQueue
+ *   writer (std::thread)   FrameQueue -> PacketFormatter -> write(1)
+ *
+ *   StampedFrame   the parser's Frame + the batch timestamp, or a marker
+ *                  for the bad frames the parser dropped just before it
+ *   Doorbell       wakes the writer once per read batch (never per frame),
+ *                  the frames themselves go through the lock-free ring
+ *                  (avionics_stack/lib/SerialProtocol/FrameQueue.hpp)
+ *   writeAll()     one write() for a whole batch of lines, partial writes
+ *                  and EINTR retried
+ *
+ * If the output stalls for longer than the ring holds, the newest frames
+ * are dropped and counted (FrameQueue::dropped()), the port keeps being
+ * read either way.
+ * -------------------------------------------------------------------------*/
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <FrameQueue.hpp>
+
+// ─────── what goes through the ring ───────
+template<typename Frame>
+struct StampedFrame : Frame
+{
+    double   ts = 0;               // when the batch it came in was read
+    bool     corrupted = false;    // marker: no frame, only the counts below
+    uint32_t badCrc = 0;           // frames dropped by the parser since the last slot
+    uint32_t badLength = 0;
+};
+
+// ─────── writer wake-up, once per batch ───────
+class Doorbell
+{
+public:
+    void ring()
+    {
+        { std::lock_guard<std::mutex> lock(m_); ++rings_; }
+        cv_.notify_one();
+    }
+
+    // No more ring() after this, the writer drains what is left and stops
+    void close()
+    {
+        { std::lock_guard<std::mutex> lock(m_); closed_ = true; }
+        cv_.notify_one();
+    }
+
+    // Sleep until the next ring() / close(). Returns false once closed.
+    bool wait()
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        cv_.wait(lock, [&] { return rings_ != seen_ || closed_; });
+        seen_ = rings_;
+        return !closed_;
+    }
+
+private:
+    std::mutex m_;
+    std::condition_variable cv_;
+    uint64_t rings_ = 0;
+    uint64_t seen_ = 0;
+    bool closed_ = false;
+};
+
+// ─────── batched output ───────
+// false if the output is gone (EPIPE, closed terminal)
+inline bool writeAll(int fd, const char* data, size_t n)
+{
+    while (n > 0) {
+        ssize_t k = ::write(fd, data, n);
+        if (k > 0) { data += k; n -= static_cast<size_t>(k); continue; }
+        if (k < 0 && errno == EINTR) continue;
+        return false;
+    }
+    return true;
+}
+
+#endif // FRAME_PIPELINE_HPP
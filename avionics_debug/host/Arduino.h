@@ -0,0 +1,57 @@
+/* host/Arduino.h  -----------------------------------------------------------
+ * Just enough of the Arduino core for avionics_stack/lib/SerialProtocol to
+ * build on a PC as is: Print, Stream and micros() / millis().
+ *
+ *     g++ -std=c++17 -I. -Ihost -I../avionics_stack/lib/SerialProtocol ...
+ *
+ * Anything that is a Stream on the ESP (HardwareSerial) is an FdStream on the
+ * host, see serial_io.hpp. The host tests (test/) build against it too.
+ * -------------------------------------------------------------------------*/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+inline unsigned long micros()
+{
+    using namespace std::chrono;
+    return static_cast<unsigned long>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buf, size_t n)
+    {
+        size_t k = 0;
+        while (n-- && write(*buf++)) ++k;
+        return k;
+    }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    // No timeout on the host: returns whatever is there, up to n bytes
+    size_t readBytes(uint8_t* buf, size_t n)
+    {
+        size_t k = 0;
+        for (int c; k < n && (c = read()) >= 0;) buf[k++] = static_cast<uint8_t>(c);
+        return k;
+    }
+};
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,380 @@
+/* packet_format.hpp  --------------------------------------------------------
+ * Prints any packet from its generated field table (packet_fields.hpp, made
+ * by avionics_stack/lib/Packets/generate_structs.cpp), no show() per packet:
+ * one lookup ID -> descriptor, then a loop over the fields.
+ *
+ *     PacketFormatter fmt(OutFormat::Json);
+ *     fmt.add(MassDrill_ID, MassPacket_desc);        // once per frame ID
+ *     fmt.addRates(LinkStats_ID, "uptime_ms");       // optional: counters as per-second rates too
+ *     fmt.packet(ts, id, payload, len, out);         // appends one line
+ *
+ * Three outputs, one line per packet:
+ *   text   1719999999.123  id=0x05 MassPacket { id=5, mass=12.5 }
+ *   csv    1719999999.123,5,MassPacket,5,12.5
+ *          (a "ts,frame_id,packet,<fields>" header the first time a packet
+ *          type shows up, so grep the packet name to get a clean table)
+ *   json   {"ts":1719999999.123,"frame_id":5,"packet":"MassPacket","id":5,"mass":12.5}
+ *
+ * With addRates() every U32 counter of that ID also gets its rate, the
+ * difference with the previous sample of the same ID over the packet's own
+ * millisecond clock field (the host timestamps say when it arrived, not when
+ * it was counted):
+ *   text   ... LinkStats { ... } per_s { bytes_in=11520.0, frames_ok=... }
+ *   csv    one "<field>/s" column per counter, empty on the first sample
+ *   json   ...,"per_s":{"bytes_in":11520.0,...}}   (not on the first sample)
+ * A sample whose clock went backwards (the ESP rebooted) starts over.
+ *
+ * Unknown IDs and wrong lengths are hex-dumped. Everything is appended to a
+ * std::string the caller reuses. Integers and hex come from two-digit lookup
+ * tables, floats from std::to_chars, and the timestamp is only formatted
+ * again when it changes (once per read batch).
+ * -------------------------------------------------------------------------*/
+#ifndef PACKET_FORMAT_HPP
+#define PACKET_FORMAT_HPP
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <packet_schema.hpp>
+
+enum class OutFormat { Text, Csv, Json };
+
+inline bool parseFormat(const std::string& s, OutFormat& out)
+{
+    if (s == "text") { out = OutFormat::Text; return true; }
+    if (s == "csv")  { out = OutFormat::Csv;  return true; }
+    if (s == "json") { out = OutFormat::Json; return true; }
+    return false;
+}
+
+class PacketFormatter
+{
+public:
+    explicit PacketFormatter(OutFormat fmt) : fmt_(fmt) {}
+
+    // Frames with this ID carry that packet
+    void add(uint8_t id, const PacketDesc& desc) { table_[id] = &desc; }
+
+    // Print the per-second rates of the U32 counters of this ID (after add()), clockField = a U32 in ms.
+    // The CSV header is per packet type: give a type rates on all of its IDs or on none.
+    bool addRates(uint8_t id, const char* clockField)
+    {
+        const PacketDesc* d = table_[id];
+        if (!d) return false;
+        for (uint8_t i = 0; i < d->fieldCount; ++i) {
+            const FieldDesc& f = d->fields[i];
+            if (f.type == FieldType::U32 && f.count == 1 && std::strcmp(f.name, clockField) == 0) {
+                rates_[id].reset(new Rates{&f, std::vector<uint8_t>(d->size), false});
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // One line for one packet (a plain frame or a superframe record)
+    void packet(double ts, uint8_t id, const uint8_t* p, size_t len, std::string& out)
+    {
+        const PacketDesc* d = table_[id];
+        if (!d || d->size != len) { raw(ts, id, p, len, out); return; }
+
+        switch (fmt_) {
+            case OutFormat::Text:
+                time(ts, out); out += "  id=0x"; hex(id, out); out += ' ';
+                out += d->name; out += " { ";
+                for (uint8_t i = 0; i < d->fieldCount; ++i) {
+                    const FieldDesc& f = d->fields[i];
+                    if (i) out += ", ";
+                    out += f.name; out += '=';
+                    values(f, p, out, '[', ']');
+                }
+                out += " }";
+                if (rates_[id]) rates(*rates_[id], *d, p, out);
+                out += '\n';
+                break;
+
+            case OutFormat::Csv:
+                if (!hasHeader(d)) header(*d, rates_[id].get(), out);
+                time(ts, out); out += ','; num(uint32_t(id), out); out += ','; out += d->name;
+                for (uint8_t i = 0; i < d->fieldCount; ++i) {
+                    out += ',';
+                    values(d->fields[i], p, out, 0, 0);
+                }
+                if (rates_[id]) rates(*rates_[id], *d, p, out);
+                out += '\n';
+                break;
+
+            case OutFormat::Json:
+                out += "{\"ts\":"; time(ts, out);
+                out += ",\"frame_id\":"; num(uint32_t(id), out);
+                out += ",\"packet\":\""; out += d->name; out += '"';
+                for (uint8_t i = 0; i < d->fieldCount; ++i) {
+                    const FieldDesc& f = d->fields[i];
+                    out += ",\""; out += f.name; out += "\":";
+                    values(f, p, out, '[', ']');
+                }
+                if (rates_[id]) rates(*rates_[id], *d, p, out);
+                out += "}\n";
+                break;
+        }
+    }
+
+    // Frames the parser dropped since the last line (bad CRC, bad length)
+    void corrupted(double ts, uint32_t crc, uint32_t length, std::string& out)
+    {
+        switch (fmt_) {
+            case OutFormat::Text:
+                time(ts, out); out += "  !! corrupted: "; num(crc, out); out += " bad CRC, ";
+                num(length, out); out += " bad length (dropped)\n";
+                break;
+            case OutFormat::Csv:
+                time(ts, out); out += ",,!corrupted,"; num(crc, out); out += ','; num(length, out); out += '\n';
+                break;
+            case OutFormat::Json:
+                out += "{\"ts\":"; time(ts, out); out += ",\"corrupted\":{\"crc\":"; num(crc, out);
+                out += ",\"length\":"; num(length, out); out += "}}\n";
+                break;
+        }
+    }
+
+    // Frames the output could not keep up with (the reader's queue was full)
+    void dropped(double ts, uint32_t frames, std::string& out)
+    {
+        switch (fmt_) {
+            case OutFormat::Text:
+                time(ts, out); out += "  !! output too slow: "; num(frames, out); out += " frames dropped\n";
+                break;
+            case OutFormat::Csv:
+                time(ts, out); out += ",,!dropped,"; num(frames, out); out += '\n';
+                break;
+            case OutFormat::Json:
+                out += "{\"ts\":"; time(ts, out); out += ",\"dropped\":"; num(frames, out); out += "}\n";
+                break;
+        }
+    }
+
+private:
+    OutFormat fmt_;
+    // The previous sample of an ID that has rates, and where its clock is
+    struct Rates {
+        const FieldDesc* clock;
+        std::vector<uint8_t> prev;
+        bool havePrev;
+    };
+
+    std::array<const PacketDesc*, 256> table_{};
+    std::array<std::unique_ptr<Rates>, 256> rates_{};
+    std::vector<const PacketDesc*> csvHeaders_;     // packet types whose header is out, a handful
+    double lastTs_ = -1;
+    char tsText_[32];
+    size_t tsLen_ = 0;
+
+    void raw(double ts, uint8_t id, const uint8_t* p, size_t len, std::string& out)
+    {
+        switch (fmt_) {
+            case OutFormat::Text:
+                time(ts, out); out += "  id=0x"; hex(id, out); out += " len="; num(uint32_t(len), out);
+                out += " payload=";
+                hexBytes(p, len, true, out);
+                out += '\n';
+                break;
+            case OutFormat::Csv:
+                time(ts, out); out += ','; num(uint32_t(id), out); out += ",raw,";
+                hexBytes(p, len, false, out);
+                out += '\n';
+                break;
+            case OutFormat::Json:
+                out += "{\"ts\":"; time(ts, out); out += ",\"frame_id\":"; num(uint32_t(id), out);
+                out += ",\"raw\":\"";
+                hexBytes(p, len, false, out);
+                out += "\"}\n";
+                break;
+        }
+    }
+
+    bool hasHeader(const PacketDesc* d)
+    {
+        for (const PacketDesc* h : csvHeaders_)
+            if (h == d) return true;
+        csvHeaders_.push_back(d);
+        return false;
+    }
+
+    void header(const PacketDesc& d, const Rates* r, std::string& out)
+    {
+        out += "ts,frame_id,packet";
+        for (uint8_t i = 0; i < d.fieldCount; ++i) {
+            const FieldDesc& f = d.fields[i];
+            for (uint8_t k = 0; k < f.count; ++k) {
+                out += ','; out += f.name;
+                if (f.count > 1) { out += '['; num(uint32_t(k), out); out += ']'; }
+            }
+        }
+        for (uint8_t i = 0; r && i < d.fieldCount; ++i)
+            if (isCounter(*r, d.fields[i])) { out += ','; out += d.fields[i].name; out += "/s"; }
+        out += '\n';
+    }
+
+    static bool isCounter(const Rates& r, const FieldDesc& f)
+    {
+        return f.type == FieldType::U32 && f.count == 1 && &f != r.clock;
+    }
+
+    static uint32_t u32(const uint8_t* p, const FieldDesc& f)
+    {
+        uint32_t x;
+        std::memcpy(&x, p + f.offset, sizeof x);
+        return x;
+    }
+
+    // The counters' rates since the previous sample of this ID (unsigned differences, so a wrap is fine)
+    void rates(Rates& r, const PacketDesc& d, const uint8_t* p, std::string& out)
+    {
+        const uint32_t ms = u32(p, *r.clock), prevMs = u32(r.prev.data(), *r.clock);
+        const bool known = r.havePrev && ms > prevMs;
+        const double dt = known ? (ms - prevMs) / 1000.0 : 0.0;
+        bool first = true;
+        if (fmt_ == OutFormat::Text && known) out += " per_s { ";
+        if (fmt_ == OutFormat::Json && known) out += ",\"per_s\":{";
+        for (uint8_t i = 0; i < d.fieldCount; ++i) {
+            const FieldDesc& f = d.fields[i];
+            if (!isCounter(r, f)) continue;
+            if (fmt_ == OutFormat::Csv) out += ',';
+            if (!known) continue;                   // CSV keeps its columns, empty
+            if (fmt_ == OutFormat::Text) { if (!first) out += ", "; out += f.name; out += '='; }
+            if (fmt_ == OutFormat::Json) { if (!first) out += ','; out += '"'; out += f.name; out += "\":"; }
+            rate((u32(p, f) - u32(r.prev.data(), f)) / dt, out);
+            first = false;
+        }
+        if (fmt_ == OutFormat::Text && known) out += " }";
+        if (fmt_ == OutFormat::Json && known) out += '}';
+        std::memcpy(r.prev.data(), p, r.prev.size());
+        r.havePrev = true;
+    }
+
+    static void rate(double x, std::string& out)
+    {
+        char buf[32];
+        auto r = std::to_chars(buf, buf + sizeof buf, x, std::chars_format::fixed, 1);
+        out.append(buf, r.ptr);
+    }
+
+    // One field, arrays as open a, b, ... close (CSV: one column per element)
+    void values(const FieldDesc& f, const uint8_t* p, std::string& out, char open, char close)
+    {
+        const uint8_t* v = p + f.offset;
+        const uint8_t step = fieldSize(f.type);
+        if (f.count > 1 && open) out += open;
+        for (uint8_t k = 0; k < f.count; ++k, v += step) {
+            if (k) out += ',';
+            value(f.type, v, out);
+        }
+        if (f.count > 1 && close) out += close;
+    }
+
+    void value(FieldType t, const uint8_t* v, std::string& out)
+    {
+        switch (t) {
+            case FieldType::U8:   num(uint32_t(*v), out); break;
+            case FieldType::Bool:
+                if (fmt_ == OutFormat::Json) out += *v ? "true" : "false";
+                else out += *v ? '1' : '0';
+                break;
+            case FieldType::U16: { uint16_t x; std::memcpy(&x, v, sizeof x); num(uint32_t(x), out); break; }
+            case FieldType::U32: { uint32_t x; std::memcpy(&x, v, sizeof x); num(x, out); break; }
+            case FieldType::I32: { int32_t x;  std::memcpy(&x, v, sizeof x); num(x, out); break; }
+            case FieldType::F32: {
+                float x; std::memcpy(&x, v, sizeof x);
+                if (!std::isfinite(x) && fmt_ == OutFormat::Json) { out += "null"; break; }
+                num(x, out);
+                break;
+            }
+        }
+    }
+
+    // "00" "01" ... "99", two digits per lookup
+    static const char* decimalPairs()
+    {
+        static const char* pairs =
+            "00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839"
+            "40414243444546474849" "50515253545556575859" "60616263646566676869" "70717273747576777879"
+            "80818283848586878889" "90919293949596979899";
+        return pairs;
+    }
+
+    // "00" "01" ... "FF"
+    static const char* hexPairs()
+    {
+        static const auto pairs = [] {
+            std::array<char, 512> t{};
+            const char digits[] = "0123456789ABCDEF";
+            for (int b = 0; b < 256; ++b) { t[2 * b] = digits[b >> 4]; t[2 * b + 1] = digits[b & 0x0F]; }
+            return t;
+        }();
+        return pairs.data();
+    }
+
+    static void num(uint32_t x, std::string& out)
+    {
+        char buf[10];
+        char* end = buf + sizeof buf;
+        char* p = end;
+        while (x >= 100) {
+            const char* d = decimalPairs() + 2 * (x % 100);
+            x /= 100;
+            *--p = d[1]; *--p = d[0];
+        }
+        if (x >= 10) { const char* d = decimalPairs() + 2 * x; *--p = d[1]; *--p = d[0]; }
+        else *--p = char('0' + x);
+        out.append(p, end);
+    }
+
+    static void num(int32_t x, std::string& out)
+    {
+        if (x < 0) { out += '-'; num(0U - static_cast<uint32_t>(x), out); return; }
+        num(static_cast<uint32_t>(x), out);
+    }
+
+    static void num(float x, std::string& out)
+    {
+        char buf[32];
+        auto r = std::to_chars(buf, buf + sizeof buf, x);
+        out.append(buf, r.ptr);
+    }
+
+    // Every line of a batch has the same timestamp, format it once
+    void time(double ts, std::string& out)
+    {
+        if (ts != lastTs_) {
+            auto r = std::to_chars(tsText_, tsText_ + sizeof tsText_, ts, std::chars_format::fixed, 3);
+            tsLen_ = static_cast<size_t>(r.ptr - tsText_);
+            lastTs_ = ts;
+        }
+        out.append(tsText_, tsLen_);
+    }
+
+    static void hex(uint8_t b, std::string& out)
+    {
+        out.append(hexPairs() + 2 * b, 2);
+    }
+
+    // The whole payload in one go: grow the string once, then two table bytes (+ a space) per byte
+    static void hexBytes(const uint8_t* p, size_t len, bool spaced, std::string& out)
+    {
+        const size_t step = spaced ? 3 : 2;
+        const size_t at = out.size();
+        out.resize(at + len * step);
+        char* w = &out[at];
+        for (size_t i = 0; i < len; ++i, w += step) {
+            std::memcpy(w, hexPairs() + 2 * p[i], 2);
+            if (spaced) w[2] = ' ';
+        }
+    }
+};
+
+#endif // PACKET_FORMAT_HPP
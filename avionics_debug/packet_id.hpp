@@ -1,33 +0,0 @@
-/**
- * @file packet_id.hpp
- * @author Eliot Abramo
-*/
-#include <iostream>
-#include "packet_definition.hpp"
-
-// Servo packets
-#define ServoCam_ID 1
-#define ServoDrill_ID 2
-
-// Mass packets
-#define MassDrill_ID 3
-#define MassDrill_Request_ID 4
-#define MassHD_ID 5
-#define MassHD_Request_ID 6
-
-// Servo packets
-#define Servo_ID 7
-#define ServoResponse_ID 8
-#define ServoConfigResponse_ID 9
-
-// LED packets
-#define LED0_ID 11
-#define LED1_ID 12
-
-// FourInOne and NPK packets
-#define FourInOne_ID 13
-#define NPK_ID 14
-
-// Dust packets
-#define DustData_ID 15
-#define Heartbeat_ID 20
@@ -1,8 +1,8 @@
-# g++ -std=c++17 -I. decode_mux.cpp -o decode_mux
-# g++ -std=c++17 -I. decode_simple.cpp -o decode_simple
+# g++ -std=c++17 -O2 -pthread -I. -Ihost -I../avionics_stack/lib/SerialProtocol -I../avionics_stack/lib/Packets decode_mux.cpp -o decode_mux
+# g++ -std=c++17 -O2 -pthread -I. -Ihost -I../avionics_stack/lib/SerialProtocol -I../avionics_stack/lib/Packets decode_simple.cpp -o decode_simple
 
 # sudo ./decode_simple /dev/ttyUSB0 115200  
-# sudo ./decode_mux /dev/ttyUSB0 115200
+# sudo ./decode_mux /dev/ttyUSB0 115200 [text|csv|json]
 
 #!/usr/bin/env bash
 #
@@ -10,24 +10,26 @@
 #
 #   Usage:
 #     ./run_decode.sh simple 0 [115200]
-#     ./run_decode.sh mux    1 [9600]
+#     ./run_decode.sh mux    1 [9600] [json]
 #
 #   Positional args
 #     1. MODE    – “simple” or “mux”
 #     2. USBIDX  – number after /dev/ttyUSB (e.g. 0 → /dev/ttyUSB0)
-#   Optional arg
+#   Optional args
 #     3. BAUD    – defaults to 115200 if omitted
+#     4. FORMAT  – text (default), csv or json (one JSON object per line)
 #
 set -euo pipefail
 
-if (( $# < 2 || $# > 3 )); then
-  echo "Usage: $0 <simple|mux> <USB index> [baudrate]" >&2
+if (( $# < 2 || $# > 4 )); then
+  echo "Usage: $0 <simple|mux> <USB index> [baudrate] [text|csv|json]" >&2
   exit 1
 fi
 
 MODE="$1"                # simple | mux
 USBIDX="$2"              # e.g. 0 → /dev/ttyUSB0
 BAUDRATE="${3:-115200}"  # default if not supplied
+FORMAT="${4:-text}"
 
 case "$MODE" in
   simple) SRC=decode_simple.cpp ; BIN=decode_simple ;;
@@ -35,10 +37,19 @@ case "$MODE" in
   *) echo "Error: first arg must be 'simple' or 'mux'" >&2; exit 1 ;;
 esac
 
-# Re-compile only if binary is missing or source is newer
-if [[ ! -x "./$BIN" || "./$BIN" -ot "$SRC" ]]; then
+# The firmware parser and packet headers are compiled as is, through the host/Arduino.h shim
+PROTO=../avionics_stack/lib/SerialProtocol
+PACKETS=../avionics_stack/lib/Packets
+CXXFLAGS=(-std=c++17 -O2 -pthread -I. -Ihost "-I$PROTO" "-I$PACKETS")
+
+# Re-compile only if binary is missing or anything it is built from is newer
+STALE=0
+for dep in "$SRC" serial_io.hpp packet_format.hpp frame_pipeline.hpp "$PROTO/SerialProtocol.hpp" "$PROTO/FrameQueue.hpp" "$PACKETS/packet_fields.hpp" "$PACKETS/packet_id.hpp"; do
+  [[ "./$BIN" -ot "$dep" ]] && STALE=1
+done
+if [[ ! -x "./$BIN" || $STALE == 1 ]]; then
   echo "Compiling $SRC → $BIN …"
-  g++ -std=c++17 -I. "$SRC" -o "$BIN"
+  g++ "${CXXFLAGS[@]}" "$SRC" -o "$BIN"
 fi
 
 DEV="/dev/ttyUSB${USBIDX}"
@@ -47,5 +58,5 @@ if [[ ! -e "$DEV" ]]; then
   exit 1
 fi
 
-echo "Running $BIN on $DEV @ $BAUDRATE baud …"
-sudo "./$BIN" "$DEV" "$BAUDRATE"
+echo "Running $BIN on $DEV @ $BAUDRATE baud ($FORMAT) …" >&2
+sudo "./$BIN" "$DEV" "$BAUDRATE" "$FORMAT"
@@ -0,0 +1,210 @@
+/* serial_io.hpp  ------------------------------------------------------------
+ * Port handling shared by decode_mux / decode_simple:
+ *
+ *   openSerial()   raw, NON-blocking port (no O_SYNC, nothing ever waits on
+ *                  a single byte)
+ *   SerialReader   sleeps in epoll (poll() on macOS) until the port has
+ *                  bytes, then drains it with big read()s: one syscall per
+ *                  batch instead of one per byte, 0 % CPU while the link is
+ *                  idle, and it returns false when the port goes away
+ *                  instead of spinning on it; wake() (any thread) gets
+ *                  it out of the wait early, e.g. once stdout is gone
+ *   FdStream       the port as an Arduino Stream (host/Arduino.h), so the
+ *                  firmware's SerialProtocol can be used as is
+ *
+ * The batches go to the firmware parser (avionics_stack/lib/SerialProtocol):
+ * length + CRC checked, frames handed out in place, no allocation.
+ *
+ *     int fd = openSerial("/dev/ttyUSB0", 115200);
+ *     FdStream port(fd);
+ *     SerialProtocol<128> parser(port);
+ *     SerialReader reader(fd);
+ *     while (reader.pump([&](const uint8_t* d, size_t n) {
+ *         parser.processBytes(d, n, [&](const auto& frame) { ... });
+ *     })) {}
+ * -------------------------------------------------------------------------*/
+#ifndef SERIAL_IO_HPP
+#define SERIAL_IO_HPP
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>              // host/Arduino.h
+
+// ─────── open & configure serial port ─────
+inline int openSerial(const std::string& dev, int baud)
+{
+    int fd = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) { perror(dev.c_str()); return -1; }
+
+    termios tty{};
+    if (tcgetattr(fd, &tty) != 0) { perror("tcgetattr"); ::close(fd); return -1; }
+    cfmakeraw(&tty);
+
+    speed_t spd = (baud == 115200) ? B115200 :
+                  (baud == 57600)  ? B57600  :
+                  (baud == 38400)  ? B38400  :
+                  (baud == 19200)  ? B19200  : B9600;
+    cfsetispeed(&tty, spd);
+    cfsetospeed(&tty, spd);
+    tty.c_cflag |= (CLOCAL | CREAD);
+    tty.c_cc[VMIN]  = 0;                        // read() returns what is there, epoll does the waiting
+    tty.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) { perror("tcsetattr"); ::close(fd); return -1; }
+
+    return fd;
+}
+
+// ─────── wait for bytes, read them in batches ───────
+class SerialReader
+{
+public:
+    static constexpr size_t kBatch = 64 * 1024;
+
+    explicit SerialReader(int fd) : fd_(fd), buf_(kBatch)
+    {
+#ifdef __linux__
+        wakeRd_ = wakeWr_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev{};
+        ev.events  = EPOLLIN;
+        ev.data.fd = fd_;
+        if (ep_ >= 0 && epoll_ctl(ep_, EPOLL_CTL_ADD, fd_, &ev) != 0) { ::close(ep_); ep_ = -1; }
+        ev.data.fd = wakeRd_;
+        if (ep_ >= 0 && wakeRd_ >= 0) epoll_ctl(ep_, EPOLL_CTL_ADD, wakeRd_, &ev);
+#else
+        int p[2];
+        if (::pipe(p) == 0) {
+            wakeRd_ = p[0];
+            wakeWr_ = p[1];
+            for (int w : p) {
+                ::fcntl(w, F_SETFL, O_NONBLOCK);
+                ::fcntl(w, F_SETFD, FD_CLOEXEC);
+            }
+        }
+#endif
+    }
+    ~SerialReader()
+    {
+#ifdef __linux__
+        if (ep_ >= 0) ::close(ep_);
+#endif
+        if (wakeWr_ >= 0 && wakeWr_ != wakeRd_) ::close(wakeWr_);
+        if (wakeRd_ >= 0) ::close(wakeRd_);
+    }
+    SerialReader(const SerialReader&) = delete;
+    SerialReader& operator=(const SerialReader&) = delete;
+
+    // Sleep until the port is readable (or timeoutMs, -1 = forever), then hand everything it has to
+    // onBytes(data, n), kBatch bytes at a time. Returns false once the port is closed / unplugged.
+    template<typename OnBytes>
+    bool pump(OnBytes&& onBytes, int timeoutMs = -1)
+    {
+        if (!wait(timeoutMs)) return false;
+        while (true) {
+            ssize_t n = ::read(fd_, buf_.data(), buf_.size());
+            if (n > 0) {
+                ++reads_;
+                bytes_ += static_cast<uint64_t>(n);
+                onBytes(buf_.data(), static_cast<size_t>(n));
+                if (static_cast<size_t>(n) < buf_.size()) return true;     // drained
+                continue;
+            }
+            if (n == 0) return !hup_;                                      // nothing (VMIN=0) or EOF after a hangup
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            return false;                                                  // EIO: device gone
+        }
+    }
+
+    // From any thread: the current (or next) pump() returns right away, true if the port is still there
+    void wake()
+    {
+        const uint64_t one = 1;         // eventfd takes 8 bytes, the pipe doesn't mind
+        if (wakeWr_ >= 0) { ssize_t r = ::write(wakeWr_, &one, sizeof one); (void)r; }
+    }
+
+    uint64_t reads() const { return reads_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    int fd_;
+    std::vector<uint8_t> buf_;
+    uint64_t reads_ = 0;
+    uint64_t bytes_ = 0;
+    bool hup_ = false;
+    int wakeRd_ = -1;               // eventfd on Linux (both ends), a pipe elsewhere
+    int wakeWr_ = -1;
+#ifdef __linux__
+    int ep_ = -1;
+#endif
+
+    void drainWake()
+    {
+        uint64_t junk[8];
+        while (::read(wakeRd_, junk, sizeof junk) > 0) {}
+    }
+
+    bool wait(int timeoutMs)
+    {
+#ifdef __linux__
+        if (ep_ >= 0) {
+            epoll_event ev[2]{};
+            int r;
+            do { r = epoll_wait(ep_, ev, 2, timeoutMs); } while (r < 0 && errno == EINTR);
+            if (r < 0) return false;
+            hup_ = false;
+            for (int i = 0; i < r; ++i) {
+                if (ev[i].data.fd == wakeRd_) drainWake();
+                else hup_ = ev[i].events & (EPOLLHUP | EPOLLERR);
+            }
+            return true;
+        }
+#endif
+        pollfd p[2] = {{fd_, POLLIN, 0}, {wakeRd_, POLLIN, 0}};
+        int r;
+        do { r = ::poll(p, wakeRd_ >= 0 ? 2 : 1, timeoutMs); } while (r < 0 && errno == EINTR);
+        if (r < 0) return false;
+        if (wakeRd_ >= 0 && (p[1].revents & POLLIN)) drainWake();
+        hup_ = r > 0 && (p[0].revents & (POLLHUP | POLLERR));
+        return true;
+    }
+};
+
+// ─────── the port as an Arduino Stream (host/Arduino.h) ───────
+// What SerialProtocol writes to. RX doesn't go through it: SerialReader reads
+// the batches and they go straight to SerialProtocol::processBytes().
+class FdStream : public Stream
+{
+public:
+    explicit FdStream(int fd) : fd_(fd) {}
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t n) override
+    {
+        ssize_t k = ::write(fd_, buf, n);
+        return k > 0 ? static_cast<size_t>(k) : 0;
+    }
+    int availableForWrite() override { return 4096; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    int fd_;
+};
+
+#endif // SERIAL_IO_HPP
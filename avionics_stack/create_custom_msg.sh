@@ -18,10 +18,10 @@ if [ $? -ne 0 ]; then
     exit 1
 fi
 
-# Define input folder and output file for the executable.
-INPUT_FOLDER="msg/avionics/"
-OUTPUT_FILE="all_structs.generated.hpp"
+# Inputs: lib/ERC_SE_CustomMessages/msg/avionics (submodule) + lib/Packets/msg (local packets).
+# Outputs: lib/Packets/packet_definition.hpp and lib/Packets/packet_fields.hpp
+OUTPUT_FOLDER="lib/Packets"
 
 # Execute the compiled program.
-echo "Running $EXE with input folder '$INPUT_FOLDER' and output file '$OUTPUT_FILE'..."
-./"$EXE" "$INPUT_FOLDER" "$OUTPUT_FILE"
+echo "Running $EXE, output in '$OUTPUT_FOLDER'..."
+./"$EXE" "$OUTPUT_FOLDER"
@@ -0,0 +1,67 @@
+/**
+ * @file EventQueue.hpp
+ * @author Eliot Abramo
+ * @brief Fixed-capacity, lock-free single-producer/single-consumer queue of small events (Change, ...).
+ * @date 2025-07-03
+ */
+#ifndef EVENT_QUEUE_HPP
+#define EVENT_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Same idea as FrameQueue (SerialProtocol/FrameQueue.hpp) but for plain structs: the RX side push()es what the
+ * application has to react to, the application pop()s it whenever it gets around to it. Nothing is lost because two
+ * requests came in the same receive() anymore, the newest event is dropped (and counted) only when the queue is full.
+ *
+ * One producer, one consumer, depth a power of two.
+ */
+template <typename T, std::size_t Depth>
+class EventQueue {
+    static_assert(Depth >= 2 && (Depth & (Depth - 1)) == 0, "EventQueue depth must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "events are copied around, keep them trivially copyable");
+
+public:
+    /** Producer side only. @return false if the queue is full (event dropped) */
+    bool push(const T &e) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Depth) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[head & kMask] = e;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side only. @return false if there was nothing to read */
+    bool pop(T &out) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return false;
+        out = slots_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr std::size_t capacity() { return Depth; }
+
+    /** Events thrown away because the consumer did not keep up */
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kMask = Depth - 1;
+
+    T slots_[Depth]{};
+    std::atomic<std::size_t> head_{0};  // written by producer only
+    std::atomic<std::size_t> tail_{0};  // written by consumer only
+    std::atomic<uint32_t> dropped_{0};
+};
+
+#endif /* EVENT_QUEUE_HPP */
@@ -6,76 +6,220 @@
 #include <Wire.h>
 #include <Arduino.h>
 #include <SerialProtocol.hpp>
+#include <TransportMux.hpp>
+#include <PacketRouter.hpp>
+#include <ReliableChannel.hpp>
+#include <Fragmentation.hpp>
 #include <packet_id.hpp>
 #include <packet_definition.hpp>
 
-static SerialProtocol<128> proto(Serial);
+/* Buffered TX: send() only copies the frame into the 512 B ring, poll() trickles it out without blocking loop() */
+#if NEXUS_UART_EVENTS
+/* IDF driver owns UART0, the RX task sleeps on its event queue (FIFO threshold / idle line) */
+static Esp32UartPort uartPort(UART_NUM_0, 115200, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                              NEXUS_UART_RX_FULL, NEXUS_UART_RX_TOUT);
+static UartLink<128, Crc16Table, 512> uart(uartPort);
+#else
+static StreamLink<128, Crc16Table, 512> uart(Serial);
+#endif
 
+#if NEXUS_SPI
+static Esp32SpiSlaveHal spiHal(SPI3_HOST, NEXUS_SPI_MOSI, NEXUS_SPI_MISO, NEXUS_SPI_SCLK, NEXUS_SPI_CS);
+static SPISlaveProtocol<128, 512> spiProto(spiHal);
+static SpiLink<decltype(spiProto)> spi(spiProto);
+#endif
 
-Nexus::Nexus()
+/* Every link goes through the MUX: RX drained from all of them, TX on the healthiest one */
+static TransportMux<128> mux;
+using Frame = decltype(mux)::Frame;
+
+#if NEXUS_BATCH_TELEMETRY
+/* Telemetry produced during one loop() tick, goes out as a single superframe in poll() */
+static SuperframeBuilder<128> batch;
+#endif
+
+/* Messages bigger than a frame, one at a time, sent from poll() as the TX ring frees up */
+static Fragmenter<128> blocks;
+
+#if NEXUS_RELIABLE
+/* Receiver side only (the ESP never sends reliably): filled by the RX task, the ACKs go out from poll() */
+static ReliableChannel<NEXUS_RELIABLE_MAX, 8> reliable;
+struct ReliableAck {
+    uint8_t bytes[kAckPayload];
+};
+static EventQueue<ReliableAck, 8> acks;
+#endif
+
+void Nexus::publish(uint8_t id, const void *pkt, uint8_t len) {
+#if NEXUS_BATCH_TELEMETRY
+    if (batch.add(id, pkt, len)) return;
+    mux.send(batch);            // batch full, ship it and start a new one
+    batch.clear();
+    if (batch.add(id, pkt, len)) return;
+#endif
+    mux.send(id, pkt, len);
+}
+
+
+Nexus::Nexus() {}
+
+/* Not in the constructor: a global Nexus is constructed before (or after) the statics above, depending on link order */
+void Nexus::begin()
 {
+#if NEXUS_UART_EVENTS
+    uartPort.begin();
+#else
     Serial.begin(115200);
+#endif
+    uart.parser().setResync(true);      // noisy harness, don't lose the frames hiding behind a corrupted one
+    uart.parser().setTimeout(20000);    // 20 ms without a byte mid-frame = the sender died, drop the partial frame
+#if NEXUS_FLOW_CONTROL
+    uart.parser().setFlowControl(true);
+#endif
+
+#if NEXUS_SPI
+    spiProto.begin();
+    mux.add(spi);                       // preferred when alive
+#endif
+    mux.add(uart);
+    mux.setQuietTimeout(NEXUS_LINK_QUIET_MS);
+    mux.setBudget(NEXUS_RX_BUDGET_BYTES);
 }
 
 Nexus::~Nexus(){}
 
-void Nexus::sendMassPacket(MassPacket* pkt, uint8_t ID) {
-    proto.send(ID, pkt, sizeof(MassPacket));
+bool Nexus::waitForData(uint32_t timeout_ms) {
+#if NEXUS_SPI
+    if (timeout_ms > 1) timeout_ms = 1;     // SPI has no RX event, it still has to be polled
+#endif
+#if NEXUS_UART_EVENTS
+    return uart.waitRx(timeout_ms);
+#else
+    if (Serial.available() > 0) return true;
+    delay(1);
+    return Serial.available() > 0;
+#endif
+}
+
+void Nexus::poll() {
+#if NEXUS_RELIABLE
+    ReliableAck ack;
+    while (acks.pop(ack)) mux.send(kAckId, ack.bytes, kAckPayload);     // never batched, the host is waiting on it
+#endif
+#if NEXUS_FLOW_CONTROL
+    /* Commands are handled as soon as they are parsed, so the room is whatever one receive() can take */
+    uart.parser().updateCredit(NEXUS_FLOW_WINDOW);
+#endif
+#if NEXUS_BATCH_TELEMETRY
+    mux.send(batch);
+    batch.clear();
+#endif
+    blocks.pump(mux);           // after the telemetry, a block never delays it by more than one tick
+    mux.service();
+}
+
+bool Nexus::sendBlock(uint8_t id, const void *data, uint32_t len) {
+    if (!blocks.begin(id, data, len)) return false;
+    blocks.pump(mux);
+    return true;
+}
+
+bool Nexus::blockBusy() const {
+    return blocks.busy();
 }
 
 void Nexus::sendHeartbeat(){
-    static uint32_t last_heartbeat = 0;
-    if (millis() - last_heartbeat >= 500) {               // every 1 s
-        uint8_t dummy = 10;
-        proto.send(Heartbeat_ID, &dummy, 1); 
-        last_heartbeat = millis();
-    }
-}
-
-void Nexus::sendDustDataPacket(DustData* pkt) {
-    proto.send(DustData_ID, pkt, sizeof(DustData));
-}
-
-Change Nexus::receive(Servo_Driver* servo_cam, Servo_Driver* servo_drill) {
-    while (Serial.available()) {
-        if (proto.processByte(Serial.read())) {
-            const auto &f = proto.frame();
-            switch (f.id) {
-                case ServoCam_ID:
-                    if (f.length == sizeof(ServoRequest)) {
-                        const ServoRequest &req = *reinterpret_cast<const ServoRequest*>(f.payload.data());
-                        servo_cam->set_request(req);
-                        servo_cam->handle_servo();
-                    }
-                    break;
-                case ServoDrill_ID:
-                    if (f.length == sizeof(ServoRequest)) {
-                        const ServoRequest &req = *reinterpret_cast<const ServoRequest*>(f.payload.data());
-                        servo_drill->set_request(req);
-                        servo_drill->handle_servo();
-                    }
-                    break;
-
-                case MassDrill_Request_ID:
-                    if (f.length == sizeof(MassRequestDrill)) {
-                        const MassRequestDrill &req = *reinterpret_cast<const MassRequestDrill*>(f.payload.data());
-                        Change changeDrill = {MassDrill_Request_ID, req.tare, req.scale};
-                        return changeDrill;
-                    }
-                    break;
-
-                case MassHD_Request_ID:
-                    if (f.length == sizeof(MassRequestHD)) {
-                        const MassRequestHD &req = *reinterpret_cast<const MassRequestHD*>(f.payload.data());
-                        Change changeHD = {MassHD_Request_ID, req.tare, req.scale};
-                        return changeHD;
-                    }
-                    break;
-
-                default:
-                    break;
-            }
-        }
-    }
-    return Change{0, 0, 0};
-}
\ No newline at end of file
+    send(Heartbeat{10});
+}
+
+void Nexus::sendLinkStats() {
+    const ProtocolStats st = mux.stats();     // all links together
+    LinkStats pkt = {
+        static_cast<uint32_t>(millis()),
+        st.bytesIn,
+        st.framesOk,
+        st.crcFailures,
+        st.lengthRejects,
+        st.timeouts,
+        st.resyncs,
+        st.txBytes,
+        st.txOverflows
+    };
+    send(pkt);
+}
+
+/* What the RX handlers work on */
+struct RxContext {
+    Servo_Driver *servo_cam;
+    Servo_Driver *servo_drill;
+    EventQueue<Change, NEXUS_EVENT_QUEUE_DEPTH> &changes;
+};
+
+static void onServoCam(RxContext &c, const ServoRequest &req) {
+    c.servo_cam->set_request(req);
+    c.servo_cam->handle_servo();
+}
+
+static void onServoDrill(RxContext &c, const ServoRequest &req) {
+    c.servo_drill->set_request(req);
+    c.servo_drill->handle_servo();
+}
+
+/* Mass requests are handed back to main through the event queue, every one of them, in order */
+static void onMassDrillRequest(RxContext &c, const MassRequestDrill &req) {
+    c.changes.push({MassDrill_Request_ID, req.tare, req.scale});
+}
+
+static void onMassHDRequest(RxContext &c, const MassRequestHD &req) {
+    c.changes.push({MassHD_Request_ID, req.tare, req.scale});
+}
+
+static void onSuperframe(RxContext &c, const uint8_t *payload, uint16_t length);
+#if NEXUS_RELIABLE
+static void onReliable(RxContext &c, const uint8_t *payload, uint16_t length);
+#endif
+
+/* Every packet the ESP accepts, one line each. Unknown IDs and wrong lengths are dropped by the router. */
+using Router = PacketRouter<RxContext, 128,
+    Route<ServoCam_ID, ServoRequest, onServoCam>,
+    Route<ServoDrill_ID, ServoRequest, onServoDrill>,
+    Route<MassDrill_Request_ID, MassRequestDrill, onMassDrillRequest>,
+    Route<MassHD_Request_ID, MassRequestHD, onMassHDRequest>,
+    RawRoute<kSuperframeId, onSuperframe>
+#if NEXUS_RELIABLE
+    , RawRoute<kReliableId, onReliable>
+#endif
+    >;
+
+/* Records go through the same table, nested superframes are not allowed */
+static void onSuperframe(RxContext &c, const uint8_t *payload, uint16_t length) {
+    forEachRecord(payload, length, [&](uint8_t rid, const uint8_t *p, uint8_t len) {
+        if (rid != kSuperframeId) Router::dispatch(c, rid, p, len);
+    });
+}
+
+#if NEXUS_RELIABLE
+/* The wrapped command goes through the same table once it is in order, duplicates (lost ACK) never reach it */
+static void onReliable(RxContext &c, const uint8_t *payload, uint16_t length) {
+    reliable.onFrame(kReliableId, payload, length, [&](uint8_t rid, const uint8_t *p, uint8_t len) {
+        if (rid != kReliableId) Router::dispatch(c, rid, p, len);
+    });
+    ReliableAck ack;
+    if (reliable.takeAck(ack.bytes)) acks.push(ack);
+}
+#endif
+
+std::size_t Nexus::receive(Servo_Driver* servo_cam, Servo_Driver* servo_drill) {
+    /* At most NEXUS_RX_BUDGET_BYTES per link per call (set in begin()), whatever is left waits for the next
+     * loop() in the UART / SPI buffers, so a command flood can't keep loop() away from the sensors */
+    RxContext ctx{servo_cam, servo_drill, changes_};
+    return mux.receive([&](const Frame &f) { Router::dispatch(ctx, f); });
+}
+
+bool Nexus::nextChange(Change &out) {
+    return changes_.pop(out);
+}
+
+uint32_t Nexus::droppedChanges() const {
+    return changes_.dropped();
+}
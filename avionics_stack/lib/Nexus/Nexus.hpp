@@ -10,9 +10,104 @@
 
 #include "packet_definition.hpp"
 #include "packet_id.hpp"
+#include "packet_traits.hpp"
+#include <cstddef>
 #include <functional>    // For std::function
 #include <unordered_map> // For std::unordered_map
 #include "Servo.hpp"
+#include "EventQueue.hpp"
+
+/**
+ * @brief 1 -> every packet sent during a loop() tick is batched and goes out as ONE superframe in poll()
+ * (see SerialProtocol/Superframe.hpp), 0 -> one frame per packet like before. The receiving side must
+ * understand superframes (avionics_debug decoders do).
+ */
+#ifndef NEXUS_BATCH_TELEMETRY
+#define NEXUS_BATCH_TELEMETRY 1
+#endif
+
+/**
+ * @brief 1 -> also talk to the Raspberry Pi over SPI (ESP32 = slave), the MUX fails over between SPI and UART.
+ * Pins default to the VSPI ones.
+ */
+#ifndef NEXUS_SPI
+#define NEXUS_SPI 0
+#endif
+#ifndef NEXUS_SPI_MOSI
+#define NEXUS_SPI_MOSI 23
+#define NEXUS_SPI_MISO 19
+#define NEXUS_SPI_SCLK 18
+#define NEXUS_SPI_CS   5
+#endif
+
+/**
+ * @brief A link with no valid frame for this long is considered dead and TX moves to another one (ms)
+ */
+#ifndef NEXUS_LINK_QUIET_MS
+#define NEXUS_LINK_QUIET_MS 500
+#endif
+
+/**
+ * @brief 1 -> UART0 is driven by the ESP-IDF UART driver and the RX task sleeps until bytes arrive (see
+ * SerialProtocol/UartPort.hpp), 0 -> Arduino Serial, polled. With 1, nobody else may Serial.begin().
+ * RX_FULL: wake up when this many bytes sit in the RX FIFO. RX_TOUT: or when the line has been idle for this many
+ * byte times (end of a frame).
+ */
+#ifndef NEXUS_UART_EVENTS
+#define NEXUS_UART_EVENTS 1
+#endif
+#ifndef NEXUS_UART_RX_FULL
+#define NEXUS_UART_RX_FULL 64
+#endif
+#ifndef NEXUS_UART_RX_TOUT
+#define NEXUS_UART_RX_TOUT 2
+#endif
+
+/**
+ * @brief 1 -> credit-based flow control on the UART link (SerialProtocol/FlowControl.hpp): telemetry is held back
+ * (dropped and counted) while the host decoder has no room, and the ESP advertises NEXUS_FLOW_WINDOW frames of room.
+ * The host side has to speak it too, so it is off by default.
+ */
+#ifndef NEXUS_FLOW_CONTROL
+#define NEXUS_FLOW_CONTROL 0
+#endif
+#ifndef NEXUS_FLOW_WINDOW
+#define NEXUS_FLOW_WINDOW 4
+#endif
+
+/**
+ * @brief 1 -> commands may also come in on the reliable channel (SerialProtocol/ReliableChannel.hpp): the host wraps
+ * tare / servo commands in kReliableId frames, the ESP ACKs them and hands each one to the router exactly once, in
+ * order. Plain command frames keep working, so it costs nothing to a host that doesn't use it.
+ * RELIABLE_MAX: biggest command that can go reliable (bytes)
+ */
+#ifndef NEXUS_RELIABLE
+#define NEXUS_RELIABLE 1
+#endif
+#ifndef NEXUS_RELIABLE_MAX
+#define NEXUS_RELIABLE_MAX 16
+#endif
+
+/**
+ * @brief Max bytes pulled from each link by one receive(), the rest stays in the driver buffers for the next loop()
+ */
+#ifndef NEXUS_RX_BUDGET_BYTES
+#define NEXUS_RX_BUDGET_BYTES 64
+#endif
+
+/**
+ * @brief How many Change events can wait between receive() and the application (power of two)
+ */
+#ifndef NEXUS_EVENT_QUEUE_DEPTH
+#define NEXUS_EVENT_QUEUE_DEPTH 8
+#endif
+
+/**
+ * @brief Period of the LinkStats packet (parser health counters) in the telemetry schedule, 0 = never sent
+ */
+#ifndef LINK_STATS_PERIOD_MS
+#define LINK_STATS_PERIOD_MS 1000
+#endif
 
 /**
  * @brief Change struct helps handle the Mass sensor tare requests from the CS.
@@ -27,9 +122,16 @@ struct Change {
 class Nexus {
 public:
     /**
-     * @brief Create a new Nexus Object
+     * @brief Create a new Nexus Object. Touches no hardware, call begin() from setup()
      */
     Nexus();
+
+    /**
+     * @brief Open the links (UART, SPI) and register them with the MUX. Call it once from setup(), before anything
+     * sends or receives.
+     * @return null
+     */
+    void begin();
     
     /**
      * @brief Destroys a Nexus Object. Should unalocate any pointers and memory used up in class
@@ -37,37 +139,87 @@ public:
     ~Nexus();
     
     /**
-     * @brief Send mass data  packet
+     * @brief Send any registered packet (see Packets->packet_traits.hpp), the ID and size come from its type.
+     * An unregistered type doesn't compile. The struct is copied straight into the tick's batch / the TX ring.
      * 
-     * @param configPacket: pointer to packet to be sent. Defined in Packets->->packet_definition.hpp
+     * @param pkt: packet to be sent. Defined in Packets->packet_definition.hpp
      * @return null 
      */
-    void sendMassPacket(MassPacket *responsePacket, uint8_t ID);
+    template <typename T>
+    void send(const T &pkt) {
+        publish(packetId(pkt), &pkt, sizeof(T));
+    }
 
     /**
-     * @brief Send sensor data packet
-     * 
-     * @param dataPacket: pointer to packet to be sent. Defined in Packets->->packet_definition.hpp
-     * @return null 
+     * @brief Send a message bigger than one frame (calibration table, block of samples, log...) as fragments
+     * (see SerialProtocol/Fragmentation.hpp). poll() sends what the TX ring can take, the rest on the next ones.
+     *
+     * @param id: packet ID of the whole message
+     * @param data: the message, must stay untouched until blockBusy() is false
+     * @param len: size in bytes
+     * @return false if the previous block is still going out
+     */
+    bool sendBlock(uint8_t id, const void *data, uint32_t len);
+
+    /**
+     * @brief The block given to sendBlock() is still being sent
      */
-    void sendDustDataPacket(DustData *dataPacket);
+    bool blockBusy() const;
 
     /**
-     * @brief functions that receive commands  
+     * @brief Receive commands, bounded: at most NEXUS_RX_BUDGET_BYTES per link per call.
+     * Servo commands are applied on the spot, mass requests are queued, read them with nextChange().
      * 
-     * @param configPacket 
-     * @param requestPacket 
-     * @param responsePacket 
-     * @return null
+     * @param servo_cam 
+     * @param servo_drill 
+     * @return number of frames handled
      */    
-    Change receive(Servo_Driver* servo_cam, Servo_Driver* servo_drill);
+    std::size_t receive(Servo_Driver* servo_cam, Servo_Driver* servo_drill);
 
     /**
-     * @brief Send heartbeat packet
+     * @brief Sleep until a link has bytes for receive(), instead of spinning on it
+     * @param timeout_ms: give up after this long (capped to 1 ms when SPI is on, SPI can only be polled)
+     * @return false on timeout
+     */
+    bool waitForData(uint32_t timeout_ms);
+
+    /**
+     * @brief Oldest mass request not handled yet
+     * @param out: filled with the request
+     * @return false if there is none
+     */
+    bool nextChange(Change &out);
+
+    /**
+     * @brief Mass requests lost because nextChange() wasn't called often enough
+     * @return counter
+     */
+    uint32_t droppedChanges() const;
+
+    /**
+     * @brief Send heartbeat packet (when is up to the caller, see the telemetry table in main.cpp)
      * @return null
      */
     void sendHeartbeat();
 
+    /**
+     * @brief Send the link statistics packet (SerialProtocol health counters of every link)
+     * @return null
+     */
+    void sendLinkStats();
+
+    /**
+     * @brief Ship the telemetry batched during this tick, the next fragments of a block, and push queued TX bytes
+     * to the UART without blocking. Call it once at the end of every loop().
+     * @return null
+     */
+    void poll();
+
+private:
+    /* Every outgoing packet goes through here, either straight on the wire or into the tick's batch */
+    void publish(uint8_t id, const void *pkt, uint8_t len);
+
+    EventQueue<Change, NEXUS_EVENT_QUEUE_DEPTH> changes_;
 };
 
 #endif /* Nexus_HPP */
\ No newline at end of file
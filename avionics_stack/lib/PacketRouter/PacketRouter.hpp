@@ -0,0 +1,123 @@
+/**
+ * @file PacketRouter.hpp
+ * @author Eliot Abramo
+ * @brief Compile-time packet router: type -> ID -> handler, expanded into a dense 256 entry function table.
+ * @date 2025-07-03
+ */
+#ifndef PACKET_ROUTER_HPP
+#define PACKET_ROUTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*************************************************** How to use *************************************************************
+ * Instead of a hand written switch (f.id) with a reinterpret_cast per case, list the routes once:
+ *
+ * struct Ctx { Servo_Driver *cam; ... };                        // whatever your handlers need
+ * static void onServoCam(Ctx &c, const ServoRequest &req) { ... }
+ *
+ * using Router = PacketRouter<Ctx, 128,
+ *     Route<ServoCam_ID, ServoRequest, onServoCam>,
+ *     Route<ServoDrill_ID, ServoRequest, onServoDrill>,
+ *     RawRoute<kSuperframeId, onSuperframe>>;                    // raw bytes, for things that are not a struct
+ *
+ * Router::dispatch(ctx, f);                                     // one indexed call, no switch
+ *
+ * Checked at compile time: two routes on the same ID, a packet that is not trivially copyable (std::string inside...)
+ * or bigger than MaxPayload. Checked at run time (has to be, it comes from the wire): the received length must be
+ * exactly sizeof(T), otherwise the frame is ignored.
+ *
+ * Adding a packet = one Route<> line, nothing else.
+*****************************************************************************************************************************/
+
+/* A packet struct on an ID, Handler is void(Ctx&, const T&) */
+template <uint8_t Id, typename T, auto Handler>
+struct Route {
+    static constexpr uint8_t kId = Id;
+    using Packet = T;
+
+    template <typename Ctx>
+    static bool call(Ctx &ctx, const uint8_t *payload, uint16_t len) {
+        if (len != sizeof(T)) return false;
+        /* Always a copy into a real T: the bytes are not a T object (strict aliasing) and a superframe record can
+         * start anywhere (no misaligned float reads). For packet-sized T it is the same loads as a cast, aligned or not. */
+        T pkt;
+        std::memcpy(&pkt, payload, sizeof(T));
+        Handler(ctx, pkt);
+        return true;
+    }
+};
+
+/* Raw bytes on an ID, Handler is void(Ctx&, const uint8_t*, uint16_t) */
+template <uint8_t Id, auto Handler>
+struct RawRoute {
+    static constexpr uint8_t kId = Id;
+    using Packet = void;
+
+    template <typename Ctx>
+    static bool call(Ctx &ctx, const uint8_t *payload, uint16_t len) {
+        Handler(ctx, payload, len);
+        return true;
+    }
+};
+
+namespace router_detail {
+
+template <typename... Routes>
+constexpr bool uniqueIds() {
+    constexpr uint8_t ids[] = {Routes::kId..., 0};
+    for (std::size_t i = 0; i < sizeof...(Routes); ++i)
+        for (std::size_t j = i + 1; j < sizeof...(Routes); ++j)
+            if (ids[i] == ids[j]) return false;
+    return true;
+}
+
+template <typename T, std::size_t MaxPayload>
+constexpr bool packetOk() {
+    if constexpr (std::is_void<T>::value) {
+        return true;
+    } else {
+        static_assert(std::is_trivially_copyable<T>::value, "packet must be trivially copyable to go on the wire");
+        static_assert(sizeof(T) <= MaxPayload, "packet bigger than MaxPayload");
+        return true;
+    }
+}
+
+} // namespace router_detail
+
+template <typename Ctx, std::size_t MaxPayload, typename... Routes>
+class PacketRouter {
+    static_assert(router_detail::uniqueIds<Routes...>(), "two routes registered on the same packet ID");
+    static_assert((router_detail::packetOk<typename Routes::Packet, MaxPayload>() && ...), "bad packet type");
+
+public:
+    using Handler = bool (*)(Ctx &, const uint8_t *, uint16_t);
+
+    /** Route one packet. @return false if nobody handles this ID or the length doesn't match the packet */
+    static bool dispatch(Ctx &ctx, uint8_t id, const uint8_t *payload, uint16_t len) {
+        const Handler h = kTable[id];
+        return h != nullptr && h(ctx, payload, len);
+    }
+
+    /** Same, straight from a received frame */
+    template <typename Frame>
+    static bool dispatch(Ctx &ctx, const Frame &f) {
+        return dispatch(ctx, f.id, f.payload.data(), f.length);
+    }
+
+    static constexpr bool handles(uint8_t id) { return kTable[id] != nullptr; }
+
+private:
+    static constexpr std::array<Handler, 256> build() {
+        std::array<Handler, 256> table{};
+        ((table[Routes::kId] = &Routes::template call<Ctx>), ...);
+        return table;
+    }
+
+    static constexpr std::array<Handler, 256> kTable = build();
+};
+
+#endif /* PACKET_ROUTER_HPP */
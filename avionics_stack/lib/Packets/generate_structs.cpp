@@ -2,12 +2,16 @@
  * @file generate_structs.hpp
  * @author Eliot Abramo
  * 
- * @brief convert avionics custom_msg into C++ structs so they can be leveraged by the code.
+ * @brief convert avionics custom_msg into C++ structs so they can be leveraged by the code, plus a field
+ * descriptor table per struct (packet_fields.hpp, see packet_schema.hpp) for the host decoder.
  * 
- * @details to execute this you need to use the ./create_custom_msg.sh script
+ * @details to execute this you need to use the ./create_custom_msg.sh script. The .msg files come from two folders:
+ * the shared ERC_SE_CustomMessages submodule (git submodule update --init) and lib/Packets/msg/ for the packets
+ * only avionics_stack uses (LinkStats, ...). Nothing is written if either folder is missing, so a missing
+ * submodule never turns into a packet_definition.hpp with half the packets gone.
  * 
  * @attention If when you generate the structs there is an error (i.e unrecognized type), go to
- * line 122 and add an else if(){} for your type.
+ * parseMsg() and add an else if(){} for your type (and to fieldType() if it can go on the wire).
  * 
 */
 
@@ -20,6 +24,7 @@
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
+#include <algorithm>
 
 // Structure to hold generated struct info.
 struct GeneratedStruct {
@@ -45,18 +50,99 @@ std::string getStructName(const std::string& filename) {
     return std::filesystem::path(filename).stem().string();
 }
 
-void generate_message_file(std::string folderPath, std::string outputFilename){
-    // Check if the input directory exists.
-    if (!std::filesystem::exists(folderPath)) {
-        std::cerr << "Directory " << folderPath << " does not exist." << std::endl;
-        return;
+// Read one .msg file: each line is "<type> <name>", lines that are empty or start with '#' are skipped.
+std::vector<Field> parseMsg(const std::filesystem::path& path) {
+    std::vector<Field> fields;
+    std::ifstream infile(path);
+    if (!infile) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        return fields;
     }
-    
+
+    std::string line;
+    while (std::getline(infile, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream iss(line);
+        std::string type, name;
+        if (!(iss >> type >> name)) {
+            std::cerr << "Error parsing line in " << path << ": " << line << std::endl;
+            continue;
+        }
+
+        // Add a _t suffix to uint8 and uint16 cases.
+        if (type == "uint8") {
+            type = "uint8_t";
+        } else if (type == "uint16") {
+            type = "uint16_t";
+        } else if (type == "float32[4]"){
+            type = "float";
+            name = name +"[4]";
+        } else if (type == "float32") {
+            type = "float";
+        } else if (type == "bool[4]"){
+            type = "bool";
+            name = name + "[4]";
+        } else if (type == "uint32[7]") {
+            type = "uint32_t";
+            name = name + "[4]";
+        } else if (type == "string" || type == "String"){
+            type = "std::string";
+        } else if (type == "uint32"){
+            type = "uint32_t";
+        } else if (type == "int32"){
+            type = "int32_t";
+        }
+
+        fields.push_back({type, name});
+    }
+    return fields;
+}
+
+// Every .msg of the folders, always in the same (struct name) order. Two files with the same name is an error.
+bool listMsg(const std::vector<std::string>& folders, std::vector<std::filesystem::path>& files) {
+    files.clear();
+    for (const auto &folderPath : folders) {
+        if (!std::filesystem::is_directory(folderPath)) {
+            std::cerr << "Directory " << folderPath << " does not exist (git submodule update --init ?)." << std::endl;
+            return false;
+        }
+        for (const auto &entry : std::filesystem::directory_iterator(folderPath)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".msg")
+                files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a.stem() < b.stem(); });
+    for (std::size_t i = 1; i < files.size(); ++i) {
+        if (files[i].stem() == files[i - 1].stem()) {
+            std::cerr << "Same message defined twice: " << files[i - 1] << " and " << files[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// C++ type of a field -> FieldType enumerator of packet_schema.hpp ("" if it can't go on the wire)
+std::string fieldType(const std::string& type) {
+    static const std::unordered_map<std::string, std::string> FIELD_TYPES = {
+        {"uint8_t", "U8"}, {"uint16_t", "U16"}, {"uint32_t", "U32"},
+        {"int32_t", "I32"}, {"float", "F32"}, {"bool", "Bool"},
+    };
+    auto it = FIELD_TYPES.find(type);
+    return it == FIELD_TYPES.end() ? "" : it->second;
+}
+
+bool generate_message_file(const std::vector<std::string>& folders, std::string outputFilename){
+    // Check the input directories exist before touching the output.
+    std::vector<std::filesystem::path> msgs;
+    if (!listMsg(folders, msgs)) return false;
+
     // Open the output file at the specified path.
     std::ofstream outfile(outputFilename);
     if (!outfile) {
         std::cerr << "Error creating output file: " << outputFilename << std::endl;
-        return;
+        return false;
     }
     
     outfile << "/** \n";
@@ -70,79 +156,102 @@ void generate_message_file(std::string folderPath, std::string outputFilename){
     outfile << "#include <iostream>\n";
     outfile << "#include <packet_id.hpp>\n\n";
     
-    // Iterate through all files in the folder.
-    for (const auto &entry : std::filesystem::directory_iterator(folderPath)) {
-        // Process only regular files with a .msg extension.
-        if (entry.is_regular_file() && entry.path().extension() == ".msg") {
-            std::ifstream infile(entry.path());
-            if (!infile) {
-                std::cerr << "Error opening file: " << entry.path() << std::endl;
-                continue;
-            }
-            
-            // Derive the struct name from the file name.
-            std::string structName = getStructName(entry.path().string());
-            std::vector<Field> fields;
-            std::string line;
-            
-            // Read each line and parse the type and variable name,
-            // skipping lines that are empty or start with '#'.
-            while (std::getline(infile, line)) {
-                if (line.empty() || line[0] == '#')
-                    continue;
-                    
-                std::istringstream iss(line);
-                std::string type, name;
-                if (!(iss >> type >> name)) {
-                    std::cerr << "Error parsing line in " << entry.path() << ": " << line << std::endl;
-                    continue;
-                }
-                
-                // Add a _t suffix to uint8 and uint16 cases.
-                if (type == "uint8") {
-                    type = "uint8_t";
-                } else if (type == "uint16") {
-                    type = "uint16_t";
-                } else if (type == "float32[4]"){
-                    type = "float";
-                    name = name +"[4]";
-                } else if (type == "float32") {
-                    type = "float";
-                } else if (type == "bool[4]"){
-                    type = "bool";
-                    name = name + "[4]";
-                } else if (type == "uint32[7]") {
-                    type = "uint32_t";
-                    name = name + "[4]";
-                } else if (type == "string" || type == "String"){
-                    type = "std::string";
-                } else if (type == "uint32"){
-                    type = "uint32_t";
-                } else if (type == "int32"){
-                    type = "int32_t";
-                }
-                
-                fields.push_back({type, name});
-            }
-            infile.close();
-            
-            // Write the struct definition to the aggregated header file.
-            outfile << "struct " << structName << " {\n";
-            for (const auto &field : fields) {
-                outfile << "    " << field.type << " " << field.name << ";\n";
-            }
-            outfile << "};\n\n";
-            
-            std::cout << "Processed file: " << entry.path() << std::endl;
+    // Iterate through all .msg files of the folders.
+    for (const auto &path : msgs) {
+        // Derive the struct name from the file name.
+        std::string structName = getStructName(path.string());
+        std::vector<Field> fields = parseMsg(path);
+
+        // Write the struct definition to the aggregated header file.
+        outfile << "struct " << structName << " {\n";
+        for (const auto &field : fields) {
+            outfile << "    " << field.type << " " << field.name << ";\n";
         }
+        outfile << "};\n\n";
+
+        std::cout << "Processed file: " << path << std::endl;
     }
     outfile << "#endif /* PACKET_DEFINITION_H */";
     outfile.close();
     std::cout << "Generated aggregated header file: " << outputFilename << std::endl;
+    return true;
+}
+
+// One FieldDesc table + PacketDesc per struct (see packet_schema.hpp), offsets left to offsetof()
+bool generate_field_file(const std::vector<std::string>& folders, std::string outputFilename){
+    std::vector<std::filesystem::path> msgs;
+    if (!listMsg(folders, msgs)) return false;
+
+    std::ofstream outfile(outputFilename);
+    if (!outfile) {
+        std::cerr << "Error creating output file: " << outputFilename << std::endl;
+        return false;
+    }
+
+    outfile << "/** \n";
+    outfile << " * @file packet_fields.hpp \n";
+    outfile << " * @author Eliot Abramo \n";
+    outfile << " * @brief Generated by generate_structs.cpp from the same .msg files as packet_definition.hpp, don't edit. \n";
+    outfile << "*/ \n\n";
+
+    outfile << "#ifndef PACKET_FIELDS_H\n";
+    outfile << "#define PACKET_FIELDS_H\n\n";
+    outfile << "#include <cstddef>\n";
+    outfile << "#include <packet_schema.hpp>\n";
+    outfile << "#include <packet_definition.hpp>\n\n";
+
+    std::vector<std::string> described;
+    for (const auto &path : msgs) {
+        std::string structName = getStructName(path.string());
+        std::vector<Field> fields = parseMsg(path);
+
+        // A field that can't go on the wire (std::string, ...) means the struct isn't a packet
+        bool wire = !fields.empty();
+        for (const auto &field : fields) {
+            if (fieldType(field.type).empty()) wire = false;
+        }
+        if (!wire) {
+            outfile << "// " << structName << ": not a wire packet (field type without a fixed size), no descriptor\n\n";
+            continue;
+        }
+
+        outfile << "inline constexpr FieldDesc " << structName << "_fields[] = {\n";
+        for (const auto &field : fields) {
+            // "name[4]" -> member "name", 4 elements
+            std::string member = field.name;
+            std::string count = "1";
+            const auto bracket = member.find('[');
+            if (bracket != std::string::npos) {
+                count = member.substr(bracket + 1, member.find(']') - bracket - 1);
+                member = member.substr(0, bracket);
+            }
+            outfile << "    {\"" << member << "\", offsetof(" << structName << ", " << member << "), FieldType::"
+                    << fieldType(field.type) << ", " << count << "},\n";
+        }
+        outfile << "};\n";
+        outfile << "inline constexpr PacketDesc " << structName << "_desc = {\"" << structName << "\", sizeof("
+                << structName << "), " << structName << "_fields, " << fields.size() << "};\n\n";
+        described.push_back(structName);
+    }
+
+    outfile << "inline constexpr const PacketDesc *kPacketDescs[] = {\n";
+    for (const auto &name : described) {
+        outfile << "    &" << name << "_desc,\n";
+    }
+    outfile << "};\n\n";
+    outfile << "#endif /* PACKET_FIELDS_H */";
+    outfile.close();
+    std::cout << "Generated field descriptor file: " << outputFilename << std::endl;
+    return true;
 }
 
-int main(){
-    generate_message_file("lib/ERC_SE_CustomMessages/msg/avionics", "lib/Packets/packet_definition.hpp");
+// Run from avionics_stack/. Output goes to lib/Packets unless another folder is given (test/ regenerates into its
+// build folder and compares with the committed files).
+int main(int argc, char* argv[]){
+    const std::vector<std::string> folders = {"lib/ERC_SE_CustomMessages/msg/avionics", "lib/Packets/msg"};
+    const std::string out = argc > 1 ? argv[1] : "lib/Packets";
+    if (!generate_message_file(folders, out + "/packet_definition.hpp")) return 1;
+    if (!generate_field_file(folders, out + "/packet_fields.hpp")) return 1;
     return 0;
 }
 
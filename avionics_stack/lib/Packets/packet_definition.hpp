@@ -9,33 +9,12 @@
 #include <iostream>
 #include <packet_id.hpp>
 
-struct LEDMessage {
-    uint8_t system;
-    uint8_t state;
-};
-
-struct ServoRequest {
-    uint8_t id;
-    int32_t increment;
-    bool zero_in;
-};
-
-struct MassRequestHD {
-    bool tare;
-    float scale;
-};
-
 struct BMS {
     std::string status;
     float v_bat;
     float current;
 };
 
-struct MassRequestDrill {
-    bool tare;
-    float scale;
-};
-
 struct DustData {
     uint16_t pm1_0_std;
     uint16_t pm2_5_std;
@@ -51,10 +30,6 @@ struct DustData {
     uint16_t num_particles_10;
 };
 
-struct Heartbeat {
-    uint8_t dummy;
-};
-
 struct FourInOne {
     uint16_t id;
     float temperature;
@@ -63,9 +38,46 @@ struct FourInOne {
     float ph;
 };
 
+struct Heartbeat {
+    uint8_t dummy;
+};
+
+struct LEDMessage {
+    uint8_t system;
+    uint8_t state;
+};
+
+struct LinkStats {
+    uint32_t uptime_ms;
+    uint32_t bytes_in;
+    uint32_t frames_ok;
+    uint32_t crc_failures;
+    uint32_t length_rejects;
+    uint32_t timeouts;
+    uint32_t resyncs;
+    uint32_t tx_bytes;
+    uint32_t tx_overflows;
+};
+
 struct MassPacket {
     uint8_t id;
     float mass;
 };
 
+struct MassRequestDrill {
+    bool tare;
+    float scale;
+};
+
+struct MassRequestHD {
+    bool tare;
+    float scale;
+};
+
+struct ServoRequest {
+    uint8_t id;
+    int32_t increment;
+    bool zero_in;
+};
+
 #endif /* PACKET_DEFINITION_H */
\ No newline at end of file
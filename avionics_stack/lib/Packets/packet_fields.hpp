@@ -0,0 +1,102 @@
+/** 
+ * @file packet_fields.hpp 
+ * @author Eliot Abramo 
+ * @brief Generated by generate_structs.cpp from the same .msg files as packet_definition.hpp, don't edit. 
+*/ 
+
+#ifndef PACKET_FIELDS_H
+#define PACKET_FIELDS_H
+
+#include <cstddef>
+#include <packet_schema.hpp>
+#include <packet_definition.hpp>
+
+// BMS: not a wire packet (field type without a fixed size), no descriptor
+
+inline constexpr FieldDesc DustData_fields[] = {
+    {"pm1_0_std", offsetof(DustData, pm1_0_std), FieldType::U16, 1},
+    {"pm2_5_std", offsetof(DustData, pm2_5_std), FieldType::U16, 1},
+    {"pm10_std", offsetof(DustData, pm10_std), FieldType::U16, 1},
+    {"pm1_0_atm", offsetof(DustData, pm1_0_atm), FieldType::U16, 1},
+    {"pm2_5_atm", offsetof(DustData, pm2_5_atm), FieldType::U16, 1},
+    {"pm10_atm", offsetof(DustData, pm10_atm), FieldType::U16, 1},
+    {"num_particles_0_3", offsetof(DustData, num_particles_0_3), FieldType::U16, 1},
+    {"num_particles_0_5", offsetof(DustData, num_particles_0_5), FieldType::U16, 1},
+    {"num_particles_1_0", offsetof(DustData, num_particles_1_0), FieldType::U16, 1},
+    {"num_particles_2_5", offsetof(DustData, num_particles_2_5), FieldType::U16, 1},
+    {"num_particles_5_0", offsetof(DustData, num_particles_5_0), FieldType::U16, 1},
+    {"num_particles_10", offsetof(DustData, num_particles_10), FieldType::U16, 1},
+};
+inline constexpr PacketDesc DustData_desc = {"DustData", sizeof(DustData), DustData_fields, 12};
+
+inline constexpr FieldDesc FourInOne_fields[] = {
+    {"id", offsetof(FourInOne, id), FieldType::U16, 1},
+    {"temperature", offsetof(FourInOne, temperature), FieldType::F32, 1},
+    {"humidity", offsetof(FourInOne, humidity), FieldType::F32, 1},
+    {"conductivity", offsetof(FourInOne, conductivity), FieldType::F32, 1},
+    {"ph", offsetof(FourInOne, ph), FieldType::F32, 1},
+};
+inline constexpr PacketDesc FourInOne_desc = {"FourInOne", sizeof(FourInOne), FourInOne_fields, 5};
+
+inline constexpr FieldDesc Heartbeat_fields[] = {
+    {"dummy", offsetof(Heartbeat, dummy), FieldType::U8, 1},
+};
+inline constexpr PacketDesc Heartbeat_desc = {"Heartbeat", sizeof(Heartbeat), Heartbeat_fields, 1};
+
+inline constexpr FieldDesc LEDMessage_fields[] = {
+    {"system", offsetof(LEDMessage, system), FieldType::U8, 1},
+    {"state", offsetof(LEDMessage, state), FieldType::U8, 1},
+};
+inline constexpr PacketDesc LEDMessage_desc = {"LEDMessage", sizeof(LEDMessage), LEDMessage_fields, 2};
+
+inline constexpr FieldDesc LinkStats_fields[] = {
+    {"uptime_ms", offsetof(LinkStats, uptime_ms), FieldType::U32, 1},
+    {"bytes_in", offsetof(LinkStats, bytes_in), FieldType::U32, 1},
+    {"frames_ok", offsetof(LinkStats, frames_ok), FieldType::U32, 1},
+    {"crc_failures", offsetof(LinkStats, crc_failures), FieldType::U32, 1},
+    {"length_rejects", offsetof(LinkStats, length_rejects), FieldType::U32, 1},
+    {"timeouts", offsetof(LinkStats, timeouts), FieldType::U32, 1},
+    {"resyncs", offsetof(LinkStats, resyncs), FieldType::U32, 1},
+    {"tx_bytes", offsetof(LinkStats, tx_bytes), FieldType::U32, 1},
+    {"tx_overflows", offsetof(LinkStats, tx_overflows), FieldType::U32, 1},
+};
+inline constexpr PacketDesc LinkStats_desc = {"LinkStats", sizeof(LinkStats), LinkStats_fields, 9};
+
+inline constexpr FieldDesc MassPacket_fields[] = {
+    {"id", offsetof(MassPacket, id), FieldType::U8, 1},
+    {"mass", offsetof(MassPacket, mass), FieldType::F32, 1},
+};
+inline constexpr PacketDesc MassPacket_desc = {"MassPacket", sizeof(MassPacket), MassPacket_fields, 2};
+
+inline constexpr FieldDesc MassRequestDrill_fields[] = {
+    {"tare", offsetof(MassRequestDrill, tare), FieldType::Bool, 1},
+    {"scale", offsetof(MassRequestDrill, scale), FieldType::F32, 1},
+};
+inline constexpr PacketDesc MassRequestDrill_desc = {"MassRequestDrill", sizeof(MassRequestDrill), MassRequestDrill_fields, 2};
+
+inline constexpr FieldDesc MassRequestHD_fields[] = {
+    {"tare", offsetof(MassRequestHD, tare), FieldType::Bool, 1},
+    {"scale", offsetof(MassRequestHD, scale), FieldType::F32, 1},
+};
+inline constexpr PacketDesc MassRequestHD_desc = {"MassRequestHD", sizeof(MassRequestHD), MassRequestHD_fields, 2};
+
+inline constexpr FieldDesc ServoRequest_fields[] = {
+    {"id", offsetof(ServoRequest, id), FieldType::U8, 1},
+    {"increment", offsetof(ServoRequest, increment), FieldType::I32, 1},
+    {"zero_in", offsetof(ServoRequest, zero_in), FieldType::Bool, 1},
+};
+inline constexpr PacketDesc ServoRequest_desc = {"ServoRequest", sizeof(ServoRequest), ServoRequest_fields, 3};
+
+inline constexpr const PacketDesc *kPacketDescs[] = {
+    &DustData_desc,
+    &FourInOne_desc,
+    &Heartbeat_desc,
+    &LEDMessage_desc,
+    &LinkStats_desc,
+    &MassPacket_desc,
+    &MassRequestDrill_desc,
+    &MassRequestHD_desc,
+    &ServoRequest_desc,
+};
+
+#endif /* PACKET_FIELDS_H */
\ No newline at end of file
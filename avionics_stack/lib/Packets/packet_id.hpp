@@ -53,4 +53,7 @@
 
 #define Heartbeat_ID 20
 
+// Link health (SerialProtocol counters)
+#define LinkStats_ID 21
+
 #endif /*PACKET_ID_HPP*/
\ No newline at end of file
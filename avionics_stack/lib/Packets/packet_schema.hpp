@@ -0,0 +1,51 @@
+/**
+ * @file packet_schema.hpp
+ * @author Eliot Abramo
+ * @brief Field descriptors (name, offset, type) of the packets, so a tool can print any packet from one table.
+ * @date 2025-07-03
+ */
+#ifndef PACKET_SCHEMA_HPP
+#define PACKET_SCHEMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The tables themselves are generated next to the structs by generate_structs.cpp (packet_fields.hpp), one per .msg:
+ *
+ *   inline constexpr FieldDesc MassPacket_fields[] = {
+ *       {"id",   offsetof(MassPacket, id),   FieldType::U8,  1},
+ *       {"mass", offsetof(MassPacket, mass), FieldType::F32, 1},
+ *   };
+ *   inline constexpr PacketDesc MassPacket_desc = {"MassPacket", sizeof(MassPacket), MassPacket_fields, 2};
+ *
+ * Offsets come from offsetof() on the real struct, so padding is whatever the compiler did.
+ * The ESP doesn't need any of it, the host decoder (avionics_debug) does.
+ */
+
+enum class FieldType : uint8_t { U8, U16, U32, I32, F32, Bool };
+
+struct FieldDesc {
+    const char *name;
+    uint16_t offset;
+    FieldType type;
+    uint8_t count;          // > 1 for arrays
+};
+
+struct PacketDesc {
+    const char *name;
+    uint16_t size;          // sizeof(struct), a frame of another length is not this packet
+    const FieldDesc *fields;
+    uint8_t fieldCount;
+};
+
+constexpr uint8_t fieldSize(FieldType t) {
+    switch (t) {
+        case FieldType::U8:
+        case FieldType::Bool: return 1;
+        case FieldType::U16:  return 2;
+        default:              return 4;
+    }
+}
+
+#endif /* PACKET_SCHEMA_HPP */
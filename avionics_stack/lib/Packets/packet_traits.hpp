@@ -0,0 +1,60 @@
+/**
+ * @file packet_traits.hpp
+ * @author Eliot Abramo
+ * @brief Compile-time packet type -> packet ID lookup, so sending a packet is just nexus.send(pkt).
+*/
+
+#ifndef PACKET_TRAITS_HPP
+#define PACKET_TRAITS_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include "packet_definition.hpp"
+#include "packet_id.hpp"
+
+/**
+ * Every packet the ESP sends has to be registered here, once. Sending a type that is not registered doesn't compile
+ * (PacketTraits<T> is only declared), so there is no way to send a struct with the wrong ID anymore.
+ *
+ * Most packets have exactly one ID -> REGISTER_PACKET(Type, Id), fixed at compile time.
+ * The exception is MassPacket, shared by the drill and the HD scale: its ID is the one stored in the packet itself,
+ * read at run time, so for MassPacket nothing checks the ID at compile time (see its trait below).
+ *
+ * Packets that only ever come IN (ServoRequest, MassRequest*) are routed in Nexus.cpp, they don't need to be here.
+ */
+template <typename T>
+struct PacketTraits;
+
+#define REGISTER_PACKET(Type, Id)                                          \
+    template <>                                                            \
+    struct PacketTraits<Type> {                                            \
+        static constexpr uint8_t id(const Type &) { return Id; }           \
+    }
+
+REGISTER_PACKET(DustData, DustData_ID);
+REGISTER_PACKET(FourInOne, FourInOne_ID);
+REGISTER_PACKET(Heartbeat, Heartbeat_ID);
+REGISTER_PACKET(LinkStats, LinkStats_ID);
+
+/* MassDrill_ID or MassHD_ID, whatever the sender put in pkt.id. NOT checked at compile time: a MassPacket goes out
+ * with whatever pkt.id holds, so fill it from MassDrill_ID / MassHD_ID, never by hand */
+template <>
+struct PacketTraits<MassPacket> {
+    static constexpr uint8_t id(const MassPacket &pkt) { return pkt.id; }
+};
+
+template <typename T, typename = void>
+struct IsRegisteredPacket : std::false_type {};
+template <typename T>
+struct IsRegisteredPacket<T, std::void_t<decltype(sizeof(PacketTraits<T>))>> : std::true_type {};
+
+/** @return the packet ID T goes out with */
+template <typename T>
+constexpr uint8_t packetId(const T &pkt) {
+    static_assert(IsRegisteredPacket<T>::value, "packet type not registered, add a REGISTER_PACKET() in packet_traits.hpp");
+    static_assert(std::is_trivially_copyable<T>::value, "packet must be trivially copyable to go on the wire");
+    static_assert(sizeof(T) <= UINT8_MAX, "packet too big for a superframe record");
+    return PacketTraits<T>::id(pkt);
+}
+
+#endif /* PACKET_TRAITS_HPP */
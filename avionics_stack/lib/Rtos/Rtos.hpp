@@ -0,0 +1,181 @@
+/**
+ * @file Rtos.hpp
+ * @author Eliot Abramo
+ * @brief Thin RTOS layer: statically allocated tasks and queues. FreeRTOS on the ESP32, std::thread on a PC.
+ * @date 2025-07-03
+ */
+#ifndef RTOS_HPP
+#define RTOS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*************************************************** How to use *************************************************************
+ * Only what avionics_stack needs, nothing allocated at run time (no xTaskCreate / xQueueCreate, the static versions):
+ *
+ * static rtos::Queue<Sample, 8> samples;                        // depth, T copied in and out
+ * static rtos::Task<4096> sensorTask;                           // stack in bytes
+ *
+ * static void sensorLoop(void *) {
+ *     while (rtos::running()) { samples.send(read(), 0); rtos::delayMs(5); }
+ * }
+ * setup():  sensorTask.start("sensor", sensorLoop, nullptr, 2, 1);   // name, fn, arg, priority, core
+ *
+ * Timeouts are in ms, 0 = don't wait, rtos::kForever = wait forever.
+ *
+ * On the ESP32 running() is always true, tasks never return. On a PC the same code runs on std::thread (priority and
+ * core are ignored), rtos::shutdown() makes running() false so the task loops end and the Task destructors join them.
+ * That's what lets the whole task graph be tested / benchmarked on a PC.
+*****************************************************************************************************************************/
+
+namespace rtos {
+
+using TaskFn = void (*)(void *arg);
+constexpr uint32_t kForever = UINT32_MAX;
+
+} // namespace rtos
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+namespace rtos {
+
+inline constexpr bool running() { return true; }
+inline void shutdown() {}
+
+inline uint32_t nowMs() { return static_cast<uint32_t>(xTaskGetTickCount() * portTICK_PERIOD_MS); }
+inline void delayMs(uint32_t ms) { vTaskDelay(ms ? pdMS_TO_TICKS(ms) : 1); }
+
+inline TickType_t ticks(uint32_t ms) { return ms == kForever ? portMAX_DELAY : pdMS_TO_TICKS(ms); }
+
+template <std::size_t StackBytes>
+class Task {
+public:
+    /** @param core: 0 or 1 (the Arduino loop() lives on 1) */
+    bool start(const char *name, TaskFn fn, void *arg, uint8_t priority, int core) {
+        handle_ = xTaskCreateStaticPinnedToCore(fn, name, StackBytes, arg, priority, stack_, &tcb_, core);
+        return handle_ != nullptr;
+    }
+
+private:
+    StaticTask_t tcb_;
+    StackType_t stack_[StackBytes / sizeof(StackType_t)];
+    TaskHandle_t handle_ = nullptr;
+};
+
+template <typename T, std::size_t Depth>
+class Queue {
+    static_assert(std::is_trivially_copyable<T>::value, "FreeRTOS queues memcpy, keep T trivially copyable");
+
+public:
+    Queue() : q_(xQueueCreateStatic(Depth, sizeof(T), storage_, &qcb_)) {}
+
+    /** @return false if still full after timeoutMs (item dropped) */
+    bool send(const T &item, uint32_t timeoutMs = 0) { return xQueueSend(q_, &item, ticks(timeoutMs)) == pdTRUE; }
+
+    /** @return false if still empty after timeoutMs */
+    bool receive(T &out, uint32_t timeoutMs = 0) { return xQueueReceive(q_, &out, ticks(timeoutMs)) == pdTRUE; }
+
+    std::size_t size() const { return uxQueueMessagesWaiting(q_); }
+
+private:
+    StaticQueue_t qcb_;
+    uint8_t storage_[Depth * sizeof(T)];
+    QueueHandle_t q_;
+};
+
+} // namespace rtos
+
+#else /* host */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace rtos {
+
+inline std::atomic<bool> &runFlag() {
+    static std::atomic<bool> flag{true};
+    return flag;
+}
+inline bool running() { return runFlag().load(std::memory_order_relaxed); }
+inline void shutdown() { runFlag().store(false); }
+
+inline uint32_t nowMs() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+inline void delayMs(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms ? ms : 1)); }
+
+template <std::size_t StackBytes>
+class Task {
+public:
+    ~Task() {
+        if (thread_.joinable()) thread_.join();
+    }
+
+    /* Priority and core don't mean anything here, the OS scheduler decides */
+    bool start(const char *, TaskFn fn, void *arg, uint8_t, int) {
+        thread_ = std::thread(fn, arg);
+        return true;
+    }
+
+private:
+    std::thread thread_;
+};
+
+template <typename T, std::size_t Depth>
+class Queue {
+    static_assert(std::is_trivially_copyable<T>::value, "FreeRTOS queues memcpy, keep T trivially copyable");
+
+public:
+    bool send(const T &item, uint32_t timeoutMs = 0) {
+        std::unique_lock<std::mutex> lock(m_);
+        if (!wait(lock, notFull_, timeoutMs, [&] { return count_ < Depth; })) return false;
+        slots_[(head_ + count_) % Depth] = item;
+        ++count_;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool receive(T &out, uint32_t timeoutMs = 0) {
+        std::unique_lock<std::mutex> lock(m_);
+        if (!wait(lock, notEmpty_, timeoutMs, [&] { return count_ > 0; })) return false;
+        out = slots_[head_];
+        head_ = (head_ + 1) % Depth;
+        --count_;
+        notFull_.notify_one();
+        return true;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(m_);
+        return count_;
+    }
+
+private:
+    mutable std::mutex m_;
+    std::condition_variable notEmpty_, notFull_;
+    T slots_[Depth]{};
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+
+    template <typename Pred>
+    static bool wait(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, uint32_t timeoutMs, Pred ready) {
+        if (timeoutMs == kForever) {
+            cv.wait(lock, ready);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+    }
+};
+
+} // namespace rtos
+
+#endif /* ESP_PLATFORM */
+
+#endif /* RTOS_HPP */
@@ -0,0 +1,131 @@
+/**
+ * @file TelemetryScheduler.hpp
+ * @author Eliot Abramo
+ * @brief Multi-rate telemetry scheduler: a static table of streams (period, phase, priority), run from loop().
+ * @date 2025-07-03
+ */
+#ifndef TELEMETRY_SCHEDULER_HPP
+#define TELEMETRY_SCHEDULER_HPP
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+/*************************************************** How to use *************************************************************
+ * static void sendMass() { ... }     static void sendDust() { ... }
+ *
+ * static const TelemetryStream streams[] = {
+ *     // name     period  phase  priority (0 = most important)  fn
+ *     {"mass",    1000,   0,     0,                             sendMass},
+ *     {"dust",    1000,   250,   1,                             sendDust},
+ * };
+ * static TelemetryScheduler<2> scheduler(streams);
+ *
+ * loop():   scheduler.tick();
+ *
+ * - Phase: first run at start + phase, then every period. Same periods with different phases = never the same tick.
+ * - At most maxPerTick streams run per tick(), most important first, the others run on the next ticks. So even when
+ *   everything is due at once (after a long blocking call...) the bus sees a trickle, not a burst.
+ * - A stream that is late by a whole period or more does NOT run several times to catch up: the missed periods are
+ *   counted as overruns and it goes back on its phase grid.
+ * - The clock is injectable (ms), give it a fake one to run the whole thing on a PC.
+*****************************************************************************************************************************/
+
+struct TelemetryStream {
+    const char *name;
+    uint32_t periodMs;     // 0 = stream disabled
+    uint32_t phaseMs;      // offset of the first run from the scheduler start
+    uint8_t priority;      // 0 runs first when several streams are due in the same tick
+    void (*fn)();
+};
+
+/* Per stream counters, jitter = how late a run was compared to its slot */
+struct StreamStats {
+    uint32_t runs = 0;
+    uint32_t overruns = 0;        // periods skipped because the stream was late by >= one period
+    uint32_t lastJitterMs = 0;
+    uint32_t maxJitterMs = 0;
+    uint32_t totalJitterMs = 0;   // / runs = mean jitter
+};
+
+template <std::size_t N>
+class TelemetryScheduler {
+public:
+    using ClockFn = unsigned long (*)();
+
+    /** @param streams: the table, has to outlive the scheduler (make it static const)
+     * @param maxPerTick: max streams run by one tick()
+     * @param clock: ms clock, injectable for tests */
+    explicit TelemetryScheduler(const TelemetryStream (&streams)[N], uint8_t maxPerTick = 1, ClockFn clock = millis)
+        : streams_(streams), maxPerTick_(maxPerTick), clock_(clock) {}
+
+    /** Set the phase origin. Optional, the first tick() does it otherwise */
+    void start() {
+        const uint32_t now = static_cast<uint32_t>(clock_());
+        for (std::size_t i = 0; i < N; ++i) next_[i] = now + streams_[i].phaseMs;
+        started_ = true;
+    }
+
+    /** Run the due streams, most important first, at most maxPerTick of them. @return number of streams run */
+    uint8_t tick() {
+        if (!started_) start();
+        const uint32_t now = static_cast<uint32_t>(clock_());
+
+        uint8_t ran = 0;
+        while (ran < maxPerTick_) {
+            const std::size_t i = mostUrgent(now);
+            if (i == N) break;
+            run(i, now);
+            ++ran;
+        }
+        return ran;
+    }
+
+    const StreamStats &stats(std::size_t i) const { return stats_[i]; }
+    const TelemetryStream &stream(std::size_t i) const { return streams_[i]; }
+    static constexpr std::size_t size() { return N; }
+
+private:
+    const TelemetryStream (&streams_)[N];
+    uint8_t maxPerTick_;
+    ClockFn clock_;
+    bool started_ = false;
+    uint32_t next_[N]{};
+    StreamStats stats_[N]{};
+
+    /* Signed difference so the comparison survives millis() wrapping */
+    static bool due(uint32_t now, uint32_t at) { return static_cast<int32_t>(now - at) >= 0; }
+
+    /* Due stream with the best priority, the one waiting the longest on a tie. @return N if nothing is due */
+    std::size_t mostUrgent(uint32_t now) const {
+        std::size_t best = N;
+        for (std::size_t i = 0; i < N; ++i) {
+            if (streams_[i].periodMs == 0 || !due(now, next_[i])) continue;
+            if (best == N || streams_[i].priority < streams_[best].priority ||
+                (streams_[i].priority == streams_[best].priority && now - next_[i] > now - next_[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void run(std::size_t i, uint32_t now) {
+        const TelemetryStream &s = streams_[i];
+        StreamStats &st = stats_[i];
+        const uint32_t late = now - next_[i];
+
+        s.fn();
+
+        ++st.runs;
+        st.lastJitterMs = late;
+        st.totalJitterMs += late;
+        if (late > st.maxJitterMs) st.maxJitterMs = late;
+
+        /* Back on the phase grid, skipping (and counting) the slots already gone */
+        const uint32_t missed = late / s.periodMs;
+        st.overruns += missed;
+        next_[i] += s.periodMs * (missed + 1);
+    }
+};
+
+#endif /* TELEMETRY_SCHEDULER_HPP */
@@ -0,0 +1,84 @@
+/**
+ * @file ByteRing.hpp
+ * @author Eliot Abramo
+ * @brief Static, lock-free single-producer/single-consumer byte ring (used for buffered TX).
+ * @date 2025-07-03
+ */
+#ifndef BYTE_RING_HPP
+#define BYTE_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Bytes are written in two steps so a frame is never half visible to the consumer:
+ *   put() as many times as needed (nothing is visible yet), then commit() publishes everything at once.
+ * Check room() before, put() does NOT check (the caller decides what happens on overflow).
+ *
+ * The consumer reads in contiguous chunks so it can hand them straight to Stream::write / a DMA buffer:
+ *   n = ring.peek(&ptr);  write(ptr, n);  ring.consume(n);
+ *
+ * One producer, one consumer, Size has to be a power of two.
+ */
+template <std::size_t Size>
+class ByteRing {
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "ByteRing size must be a power of two");
+
+public:
+    /** Free space left for the producer (staged bytes included) */
+    std::size_t room() const {
+        return Size - (staged_ - tail_.load(std::memory_order_acquire));
+    }
+
+    /** Stage bytes, not visible to the consumer until commit() */
+    void put(const uint8_t *data, std::size_t len) {
+        const std::size_t at = staged_ & kMask;
+        const std::size_t first = (len < Size - at) ? len : Size - at;
+        std::memcpy(&buf_[at], data, first);
+        std::memcpy(&buf_[0], data + first, len - first);
+        staged_ += len;
+    }
+    void put(uint8_t b) {
+        buf_[staged_ & kMask] = b;
+        ++staged_;
+    }
+
+    /** Publish everything staged since the last commit */
+    void commit() { head_.store(staged_, std::memory_order_release); }
+
+    /** Drop everything staged since the last commit */
+    void rollback() { staged_ = head_.load(std::memory_order_relaxed); }
+
+    /** Bytes ready for the consumer */
+    std::size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr std::size_t capacity() { return Size; }
+
+    /** Longest contiguous readable chunk, *data points to it. 0 if empty. */
+    std::size_t peek(const uint8_t **data) const {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t avail = head_.load(std::memory_order_acquire) - tail;
+        const std::size_t at = tail & kMask;
+        *data = &buf_[at];
+        return (avail < Size - at) ? avail : Size - at;
+    }
+
+    /** Release n bytes returned by peek() */
+    void consume(std::size_t n) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::size_t kMask = Size - 1;
+
+    uint8_t buf_[Size]{};
+    std::size_t staged_ = 0;            // producer only
+    std::atomic<std::size_t> head_{0};  // published by producer
+    std::atomic<std::size_t> tail_{0};  // published by consumer
+};
+
+#endif /* BYTE_RING_HPP */
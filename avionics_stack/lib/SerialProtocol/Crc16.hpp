@@ -0,0 +1,111 @@
+/**
+ * @file Crc16.hpp
+ * @author Eliot Abramo
+ * @brief CRC16 engines used by SerialProtocol (poly 0xA001 reflected, init 0xFFFF, no final xor).
+ * @date 2025-07-03
+ */
+#ifndef CRC16_HPP
+#define CRC16_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*************************************************** Which one? *************************************************************
+ * All engines give the exact same CRC, they only trade flash for speed. Pick one as the second template argument of
+ * SerialProtocol (default is Crc16Table):
+ *
+ *   Crc16Bitwise -> no table, 8 shift/xor per byte. Use it if you are really tight on flash.
+ *   Crc16Table   -> 256 entry table (512 B of flash), one lookup per byte.
+ *   Crc16Slice4  -> 4 x 256 entries (2 KB), eats 4 bytes per iteration on long runs.
+ *   Crc16Slice8  -> 8 x 256 entries (4 KB), eats 8 bytes per iteration on long runs.
+ *
+ * Every engine exposes the same two static functions:
+ *   update(crc, byte)            -> single byte, what the processByte() state machine uses
+ *   update(crc, data, len)       -> whole run of bytes, what send() and the bulk paths use
+ *
+ * The tables are generated by the compiler (constexpr), so nothing runs at boot and they live in flash.
+*****************************************************************************************************************************/
+
+namespace crc16_detail {
+
+constexpr uint16_t kPoly = 0xA001; // reflected 0x8005
+constexpr uint16_t kInit = 0xFFFF;
+
+/* Reference implementation, this is what everything else is checked against */
+constexpr uint16_t bitwiseByte(uint16_t crc, uint8_t b) {
+    crc ^= b;
+    for (uint8_t i = 0; i < 8; ++i) crc = (crc & 1) ? (crc >> 1) ^ kPoly : crc >> 1;
+    return crc;
+}
+
+/* T[0] is the classic byte table, T[k][i] is the CRC of byte i followed by k zero bytes */
+template <std::size_t Slices>
+struct Tables {
+    uint16_t t[Slices][256];
+};
+
+template <std::size_t Slices>
+constexpr Tables<Slices> makeTables() {
+    Tables<Slices> tab{};
+    for (uint16_t i = 0; i < 256; ++i) tab.t[0][i] = bitwiseByte(0, static_cast<uint8_t>(i));
+    for (std::size_t k = 1; k < Slices; ++k) {
+        for (uint16_t i = 0; i < 256; ++i) {
+            const uint16_t prev = tab.t[k - 1][i];
+            tab.t[k][i] = static_cast<uint16_t>((prev >> 8) ^ tab.t[0][prev & 0xFF]);
+        }
+    }
+    return tab;
+}
+
+} // namespace crc16_detail
+
+/* No table at all, slowest but zero flash */
+struct Crc16Bitwise {
+    static constexpr uint16_t kInit = crc16_detail::kInit;
+
+    static constexpr uint16_t update(uint16_t crc, uint8_t b) {
+        return crc16_detail::bitwiseByte(crc, b);
+    }
+    static uint16_t update(uint16_t crc, const uint8_t *data, std::size_t len) {
+        for (std::size_t i = 0; i < len; ++i) crc = crc16_detail::bitwiseByte(crc, data[i]);
+        return crc;
+    }
+};
+
+/* Slice-by-N, N tables of 256 entries. N = 1 is the plain table driven CRC. */
+template <std::size_t Slices>
+struct Crc16Sliced {
+    static_assert(Slices >= 1, "need at least one table");
+
+    static constexpr uint16_t kInit = crc16_detail::kInit;
+    static constexpr crc16_detail::Tables<Slices> kTables = crc16_detail::makeTables<Slices>();
+
+    static constexpr uint16_t update(uint16_t crc, uint8_t b) {
+        return static_cast<uint16_t>((crc >> 8) ^ kTables.t[0][(crc ^ b) & 0xFF]);
+    }
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, std::size_t len) {
+        if constexpr (Slices > 1) {
+            /* The 2 CRC bytes fold into the first 2 data bytes, the others only need their own table */
+            while (len >= Slices) {
+                crc ^= static_cast<uint16_t>(data[0] | (static_cast<uint16_t>(data[1]) << 8));
+                uint16_t r = kTables.t[Slices - 1][crc & 0xFF] ^ kTables.t[Slices - 2][crc >> 8];
+                for (std::size_t k = 2; k < Slices; ++k) r ^= kTables.t[Slices - 1 - k][data[k]];
+                crc = r;
+                data += Slices;
+                len -= Slices;
+            }
+        }
+        while (len--) crc = update(crc, *data++);
+        return crc;
+    }
+};
+
+using Crc16Table  = Crc16Sliced<1>;
+using Crc16Slice4 = Crc16Sliced<4>;
+using Crc16Slice8 = Crc16Sliced<8>;
+
+static_assert(Crc16Table::update(crc16_detail::kInit, 0x31) == Crc16Bitwise::update(crc16_detail::kInit, 0x31),
+              "table and bitwise CRC engines disagree");
+
+#endif /* CRC16_HPP */
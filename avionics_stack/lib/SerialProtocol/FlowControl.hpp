@@ -0,0 +1,134 @@
+/**
+ * @file FlowControl.hpp
+ * @author Eliot Abramo
+ * @brief Credit-based flow control bookkeeping for SerialProtocol (optional, both sides have to turn it on).
+ * @date 2025-07-03
+ */
+#ifndef FLOW_CONTROL_HPP
+#define FLOW_CONTROL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/*************************************************** How it works ***********************************************************
+ * Each side tells the other how many frames it can still take, the other side never sends more than that.
+ *
+ * The receiver sends a credit frame (ID kCreditId, protocol range, never reaches the application):
+ *
+ *   +---------------------+----------------+
+ *   | uint32 received     | uint16 free    |      little endian
+ *   +---------------------+----------------+
+ *   received: data frames it has parsed so far (cumulative, wraps)
+ *   free:     frames it can still buffer right now (free RX slots, given by the application)
+ *
+ * The sender may have at most `free` frames in flight after `received`, so it can send while
+ *   sent - received < free
+ * Everything is cumulative, so a lost credit frame costs nothing: the next one (keepalive) says it all again.
+ * A lost DATA frame would leak one credit forever (counted as sent, never received). So once per keepalive period the
+ * sender compares what it had sent one period ago with what the peer says it received: anything older than a period
+ * that still didn't arrive is declared lost and its credit comes back. keepaliveUs has to be longer than the round
+ * trip (TX ring + wire + the peer's credit frame coming back). A frame written off that way may only be late: when it
+ * lands the peer's count gets ahead of ours, sent is then pulled up to received (never the other way round, and the
+ * in-flight compare is signed so the sender can't lock itself out). Counts alone can't tell late from lost, so the
+ * frames sent between the write-off and the late arrival are forgotten: at worst one extra window goes out.
+ *
+ * Control frames (credit frames) are never held back, and they don't use credit.
+ *
+ * The RX side (onCredit, onData) and the TX side (canSend, onSent, advert) may live on different tasks, the counters
+ * they share are atomics.
+*****************************************************************************************************************************/
+
+/* Protocol level IDs live at the top of the ID space (see Superframe.hpp), 0xF0 is the superframe */
+constexpr uint8_t kCreditId = 0xF1;
+constexpr uint16_t kCreditPayload = 6;
+
+class CreditFlow {
+public:
+    /** @param advertStep: send a new credit frame once the grant grew by this many frames
+     * @param keepaliveUs: re-send the grant at least this often, and time after which in-flight frames are lost */
+    void configure(uint16_t advertStep, uint32_t keepaliveUs) {
+        step_ = advertStep ? advertStep : 1;
+        keepaliveUs_ = keepaliveUs;
+    }
+
+    /****************************** Sender side ******************************/
+
+    bool canSend() const {
+        /* Signed: right after late frames arrive the peer may be ahead of sent_ until onCredit() catches it up */
+        const int32_t inFlight = static_cast<int32_t>(sent_.load(std::memory_order_relaxed) -
+                                                      peerReceived_.load(std::memory_order_acquire));
+        return inFlight < static_cast<int32_t>(peerFree_.load(std::memory_order_relaxed));
+    }
+
+    void onSent() { sent_.fetch_add(1, std::memory_order_relaxed); }
+
+    /** A credit frame came in */
+    void onCredit(const uint8_t *p, uint16_t len, uint32_t nowUs) {
+        if (len != kCreditPayload) return;
+        uint32_t received;
+        uint16_t free;
+        std::memcpy(&received, p, sizeof(received));
+        std::memcpy(&free, p + sizeof(received), sizeof(free));
+
+        /* Frames sent more than a period ago and still not received were lost on the wire, take their credit back.
+         * Never below what the peer already has */
+        if (nowUs - snapUs_ >= keepaliveUs_) {
+            const int32_t lost = static_cast<int32_t>(snapSent_ - received);
+            const int32_t pending = static_cast<int32_t>(sent_.load(std::memory_order_relaxed) - received);
+            const int32_t reclaim = lost < pending ? lost : pending;
+            if (reclaim > 0) sent_.fetch_sub(static_cast<uint32_t>(reclaim), std::memory_order_relaxed);
+            snapSent_ = sent_.load(std::memory_order_relaxed);
+            snapUs_ = nowUs;
+        }
+
+        /* Some of the frames written off were only late and got there after all: the peer can't have more than we
+         * sent, pull sent_ up to its count */
+        uint32_t sent = sent_.load(std::memory_order_relaxed);
+        while (static_cast<int32_t>(received - sent) > 0 &&
+               !sent_.compare_exchange_weak(sent, received, std::memory_order_relaxed)) {}
+
+        peerFree_.store(free, std::memory_order_relaxed);
+        peerReceived_.store(received, std::memory_order_release);
+    }
+
+    /****************************** Receiver side ******************************/
+
+    void onData() { received_.fetch_add(1, std::memory_order_relaxed); }
+
+    /** @return true if a credit frame should go out now, its payload is then in out[kCreditPayload] */
+    bool advert(uint16_t free, uint32_t nowUs, uint8_t *out) {
+        const uint32_t received = received_.load(std::memory_order_relaxed);
+        const uint32_t limit = received + free;
+        const bool grew = static_cast<int32_t>(limit - lastLimit_) >= static_cast<int32_t>(step_);
+        const bool reopened = lastFree_ == 0 && free > 0;
+        const bool keepalive = nowUs - lastAdvertUs_ >= keepaliveUs_;
+        if (!(grew || reopened || keepalive || first_)) return false;
+
+        std::memcpy(out, &received, sizeof(received));
+        std::memcpy(out + sizeof(received_), &free, sizeof(free));
+        lastLimit_ = limit;
+        lastFree_ = free;
+        lastAdvertUs_ = nowUs;
+        first_ = false;
+        return true;
+    }
+
+private:
+    uint16_t step_ = 2;
+    uint32_t keepaliveUs_ = 100000;
+
+    std::atomic<uint32_t> sent_{0};           // data frames we sent
+    std::atomic<uint32_t> peerReceived_{0};   // last thing the peer said it received
+    std::atomic<uint16_t> peerFree_{0};       // no credit until the peer speaks
+    uint32_t snapSent_ = 0;                   // sent_ one period ago (RX side only)
+    uint32_t snapUs_ = 0;
+
+    std::atomic<uint32_t> received_{0};       // data frames we parsed
+    uint32_t lastLimit_ = 0;
+    uint16_t lastFree_ = 0;
+    uint32_t lastAdvertUs_ = 0;
+    bool first_ = true;
+};
+
+#endif /* FLOW_CONTROL_HPP */
@@ -0,0 +1,230 @@
+/**
+ * @file Fragmentation.hpp
+ * @author Eliot Abramo
+ * @brief Messages bigger than MaxPayload: split into numbered fragments, reassembled (or streamed) on the other side.
+ * @date 2025-07-03
+ */
+#ifndef FRAGMENTATION_HPP
+#define FRAGMENTATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*************************************************** How it works ***********************************************************
+ * A big message (calibration table, block of samples, log, ...) goes out as a train of normal frames with ID
+ * kFragmentId, each one carrying a piece of it behind a small header:
+ *
+ *   +-----------+----------+--------------+--------------+----------------------+
+ *   | uint8 seq | uint8 id | uint32 offset| uint32 total | data[len - 10]       |     little endian
+ *   +-----------+----------+--------------+--------------+----------------------+
+ *   seq:    message number (wraps), tells two messages apart
+ *   id:     the real packet ID of the whole message
+ *   offset: where this piece goes, fragment number = offset / (MaxPayload - kFragmentHeader)
+ *   total:  size of the whole message
+ *
+ * Fragments have to come in order (one link, one sender). A missing fragment kills the message: the receiver reports it
+ * incomplete and waits for the next one, nothing is ever stitched out of two different messages. Resend at the
+ * application level if it matters.
+ *
+ * TX:   Fragmenter<128> frag;
+ *       frag.begin(CalTable_ID, table, sizeof(table));      // table must stay alive until frag.busy() is false
+ *       frag.pump(proto);                                    // every loop, sends what the TX ring can take
+ *
+ * RX, whole message in a buffer you own:
+ *       static uint8_t buf[4096];
+ *       Reassembler rx(buf, sizeof(buf));
+ *       rx.onFrame(f.id, f.payload.data(), f.length, [](uint8_t id, const uint8_t *msg, uint32_t len) { ... });
+ *
+ * RX, streaming (nothing buffered, e.g. straight to flash), any object with
+ *       bool begin(uint8_t id, uint32_t total);               // false = not interested, skip this message
+ *       void data(uint32_t offset, const uint8_t *p, uint16_t n);
+ *       void end(bool complete);                              // false = a fragment was lost, throw away what you got
+ *   FragmentStream stream;  stream.onFrame(f.id, f.payload.data(), f.length, consumer);
+*****************************************************************************************************************************/
+
+/* Protocol level IDs live at the top of the ID space (see Superframe.hpp / FlowControl.hpp / ReliableChannel.hpp) */
+constexpr uint8_t kFragmentId = 0xF4;
+constexpr uint16_t kFragmentHeader = 10;
+
+struct FragmentStats {
+    uint32_t messages = 0;      // delivered complete
+    uint32_t incomplete = 0;    // a fragment went missing (gap, or a new message started before the end)
+    uint32_t skipped = 0;       // refused by the consumer (too big, not interested)
+    uint32_t orphans = 0;       // fragments of a message whose start we never saw
+};
+
+/* Sender side: owns nothing but a pointer, the message has to stay alive until busy() is false */
+template <std::size_t MaxPayload>
+class Fragmenter {
+    static_assert(MaxPayload > kFragmentHeader, "no room for data behind the fragment header");
+
+public:
+    static constexpr uint16_t kChunk = static_cast<uint16_t>(MaxPayload - kFragmentHeader);
+
+    /** Start sending a message. @return false if the previous one is still going out */
+    bool begin(uint8_t id, const void *data, uint32_t len) {
+        if (busy()) return false;
+        data_ = static_cast<const uint8_t*>(data);
+        id_ = id;
+        total_ = len;
+        offset_ = 0;
+        first_ = true;
+        active_ = true;
+        ++seq_;
+        return true;
+    }
+
+    /** Send as many fragments as the link can queue right now, never blocks and never overflows the TX ring.
+     * @param tx: anything with canQueue(len) and send(id, payload, len) (SerialProtocol, SPISlaveProtocol, TransportMux)
+     * @return number of fragments sent */
+    template <typename Tx>
+    std::size_t pump(Tx &tx) {
+        std::size_t sent = 0;
+        while (busy()) {
+            const uint32_t left = total_ - offset_;
+            const uint16_t n = left < kChunk ? static_cast<uint16_t>(left) : kChunk;
+            const uint16_t len = static_cast<uint16_t>(kFragmentHeader + n);
+            if (!tx.canQueue(len)) break;
+
+            uint8_t frame[MaxPayload];
+            frame[0] = seq_;
+            frame[1] = id_;
+            std::memcpy(frame + 2, &offset_, sizeof(offset_));
+            std::memcpy(frame + 6, &total_, sizeof(total_));
+            std::memcpy(frame + kFragmentHeader, data_ + offset_, n);
+            if (!tx.send(kFragmentId, frame, len)) break;
+
+            offset_ += n;
+            first_ = false;
+            ++sent;
+        }
+        return sent;
+    }
+
+    /** Still fragments to send (an empty message still sends one, header only) */
+    bool busy() const { return active_ && (first_ || offset_ < total_); }
+
+    /** Stop sending the current message (the receiver will see it incomplete) */
+    void cancel() { active_ = false; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    uint32_t total_ = 0;
+    uint32_t offset_ = 0;
+    uint8_t id_ = 0;
+    uint8_t seq_ = 0;
+    bool first_ = false;
+    bool active_ = false;
+};
+
+/* Receiver side, streaming: checks the order and hands every fragment to the consumer, stores nothing */
+class FragmentStream {
+public:
+    /** Feed a received frame. @return false if it is not a fragment (not kFragmentId) */
+    template <typename Consumer>
+    bool onFrame(uint8_t id, const uint8_t *p, uint16_t len, Consumer &c) {
+        if (id != kFragmentId) return false;
+        if (len < kFragmentHeader) return true;
+
+        const uint8_t seq = p[0];
+        uint32_t offset, total;
+        std::memcpy(&offset, p + 2, sizeof(offset));
+        std::memcpy(&total, p + 6, sizeof(total));
+        const uint16_t n = static_cast<uint16_t>(len - kFragmentHeader);
+
+        if (state_ != State::Idle && seq != seq_) {     // a new message, the last one never finished
+            if (state_ == State::Active) abort(c);
+            state_ = State::Idle;
+        }
+        if (state_ == State::Idle) {
+            if (offset != 0) {                          // we missed its first fragment
+                ++stats_.orphans;
+                return true;
+            }
+            seq_ = seq;
+            total_ = total;
+            next_ = 0;
+            if (!c.begin(p[1], total)) {
+                ++stats_.skipped;
+                state_ = State::Skipping;
+                return true;
+            }
+            state_ = State::Active;
+        }
+        if (state_ == State::Skipping) return true;
+
+        if (offset != next_ || total != total_ || n > total_ - next_) {    // lost a fragment in between
+            abort(c);
+            state_ = State::Skipping;
+            return true;
+        }
+        if (n) c.data(offset, p + kFragmentHeader, n);
+        next_ += n;
+        if (next_ == total_) {
+            c.end(true);
+            ++stats_.messages;
+            state_ = State::Idle;
+        }
+        return true;
+    }
+
+    const FragmentStats &stats() const { return stats_; }
+
+private:
+    enum class State : uint8_t { Idle, Active, Skipping };
+
+    State state_ = State::Idle;
+    uint8_t seq_ = 0;
+    uint32_t total_ = 0;
+    uint32_t next_ = 0;
+    FragmentStats stats_{};
+
+    template <typename Consumer>
+    void abort(Consumer &c) {
+        c.end(false);
+        ++stats_.incomplete;
+    }
+};
+
+/* Receiver side, whole message: reassembled into a buffer the caller owns, messages bigger than it are skipped */
+class Reassembler {
+public:
+    Reassembler(uint8_t *buf, std::size_t capacity) : buf_(buf), cap_(capacity) {}
+
+    /** Feed a received frame, onMessage(id, data, len) is called once a message is complete (data = the buffer,
+     * valid until the next onFrame()). @return false if it is not a fragment */
+    template <typename OnMessage>
+    bool onFrame(uint8_t id, const uint8_t *p, uint16_t len, OnMessage &&onMessage) {
+        Sink<OnMessage> sink{*this, onMessage};
+        return stream_.onFrame(id, p, len, sink);
+    }
+
+    const FragmentStats &stats() const { return stream_.stats(); }
+
+private:
+    template <typename OnMessage>
+    struct Sink {
+        Reassembler &r;
+        OnMessage &onMessage;
+
+        bool begin(uint8_t id, uint32_t total) {
+            if (total > r.cap_) return false;
+            r.id_ = id;
+            r.len_ = total;
+            return true;
+        }
+        void data(uint32_t offset, const uint8_t *p, uint16_t n) { std::memcpy(r.buf_ + offset, p, n); }
+        void end(bool complete) {
+            if (complete) onMessage(r.id_, static_cast<const uint8_t*>(r.buf_), r.len_);
+        }
+    };
+
+    uint8_t *buf_;
+    std::size_t cap_;
+    uint8_t id_ = 0;
+    uint32_t len_ = 0;
+    FragmentStream stream_;
+};
+
+#endif /* FRAGMENTATION_HPP */
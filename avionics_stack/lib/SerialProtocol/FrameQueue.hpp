@@ -0,0 +1,116 @@
+/**
+ * @file FrameQueue.hpp
+ * @author Eliot Abramo
+ * @brief Fixed-capacity, lock-free single-producer/single-consumer ring of completed frames.
+ * @date 2025-07-03
+ */
+#ifndef FRAME_QUEUE_HPP
+#define FRAME_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*************************************************** How to use *************************************************************
+ * The parser only keeps one frame, so the next one overwrites it. If the thing feeding the parser (UART ISR, RX task)
+ * is not the thing handling the frames (application task), put this in between:
+ *
+ * static FrameQueue<decltype(proto)::Frame, 8> rxFrames;     // depth has to be a power of two
+ *
+ * // RX side (ISR / RX task), the ONLY producer
+ * proto.processBytes(buf, n, rxFrames);                     // or rxFrames.push(proto.frame()) after processByte()
+ *
+ * // App side, the ONLY consumer
+ * decltype(proto)::Frame f;
+ * while (rxFrames.pop(f)) handleFrame(f);
+ *
+ * Exactly one producer and one consumer, that's what makes it lock-free (no mutex, no critical section, ISR safe).
+ * If the consumer is too slow the newest frame is dropped and counted in dropped(), we never block the producer.
+ *
+ * Frame can be anything with id / length / payload, e.g. a struct deriving from the parser's Frame with a timestamp.
+ * push() only copies those three, to fill the other fields write the slot in place instead:
+ *
+ * if (auto *slot = rxFrames.back()) { slot->id = f.id; ...; slot->rxTime = now; rxFrames.commit(); }
+*****************************************************************************************************************************/
+
+template <typename Frame, std::size_t Depth>
+class FrameQueue {
+    static_assert(Depth >= 2 && (Depth & (Depth - 1)) == 0, "FrameQueue depth must be a power of two");
+
+public:
+    /** Copy a frame in (ID, length and only the used part of the payload). Producer side only.
+     * @return false if the queue is full (frame dropped) */
+    bool push(const Frame &f) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Depth) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Frame &slot = slots_[head & kMask];
+        slot.id = f.id;
+        slot.length = f.length;
+        std::memcpy(slot.payload.data(), f.payload.data(), f.length);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Zero-copy producer API: the free slot the next frame goes in, fill it then commit() it. Producer side only.
+     * @return nullptr if the queue is full (counted in dropped(), same as push()) */
+    Frame *back() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Depth) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots_[head & kMask];
+    }
+    void commit() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /** Lets the queue be passed straight to SerialProtocol::processBytes() as the frame callback */
+    void operator()(const Frame &f) { push(f); }
+
+    /** Copy the oldest frame out. Consumer side only.
+     * @return false if there was nothing to read */
+    bool pop(Frame &out) {
+        const Frame *f = front();
+        if (f == nullptr) return false;
+        out.id = f->id;
+        out.length = f->length;
+        std::memcpy(out.payload.data(), f->payload.data(), f->length);
+        release();
+        return true;
+    }
+
+    /** Zero-copy consumer API: look at the oldest frame in place, then release() it when you are done.
+     * @return nullptr if empty */
+    const Frame *front() const {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return nullptr;
+        return &slots_[tail & kMask];
+    }
+    void release() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr std::size_t capacity() { return Depth; }
+
+    /** Frames thrown away because the consumer did not keep up */
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kMask = Depth - 1;
+
+    Frame slots_[Depth]{};
+    std::atomic<std::size_t> head_{0};  // written by producer only
+    std::atomic<std::size_t> tail_{0};  // written by consumer only
+    std::atomic<uint32_t> dropped_{0};
+};
+
+#endif /* FRAME_QUEUE_HPP */
@@ -0,0 +1,302 @@
+/**
+ * @file ReliableChannel.hpp
+ * @author Eliot Abramo
+ * @brief Optional reliable delivery on top of SerialProtocol: sequence numbers, selective-ACK window, retransmission.
+ * @date 2025-07-03
+ */
+#ifndef RELIABLE_CHANNEL_HPP
+#define RELIABLE_CHANNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*************************************************** How it works ***********************************************************
+ * For the few packets that MUST arrive (tare, servo commands). Telemetry stays plain frames, this costs bytes and RAM.
+ *
+ * A reliable message is a normal frame with ID kReliableId, the real packet rides inside:
+ *
+ *   +-----------+------------+---------------+----------+---------------------+
+ *   | uint8 seq | uint8 base | uint8 session | uint8 id | payload[len]        |
+ *   +-----------+------------+---------------+----------+---------------------+
+ *   seq:     this message's sequence number
+ *   base:    oldest message the sender still cares about, everything before it was given up (see maxRetries)
+ *   session: picked by the sender in begin(), different on every start
+ *
+ * The receiver answers with an ACK frame (ID kAckId):
+ *
+ *   +-----------+---------------+---------------------+
+ *   | uint8 cum | uint8 session | uint32 sack (LE)    |
+ *   +-----------+---------------+---------------------+
+ *   cum:     next seq expected in order (everything before it is received)
+ *   session: the one of the messages it ACKs, the sender ignores ACKs for another session
+ *   sack:    bit i set = seq cum + 1 + i received too (selective ACK, only the holes get resent)
+ *
+ * Sender: at most Window messages in flight, each one resent every rtoUs until ACKed, given up after maxRetries.
+ * A hole in the SACK bitmap (a later message made it, this one didn't) is resent right away, once, without waiting
+ * for the RTO.
+ * Receiver: out-of-order messages wait in a reorder buffer, delivery to the application is in order, exactly once.
+ *
+ * Restarts: sequence numbers alone can't tell a restarted peer from an old retransmission (a new seq 0 looks like a
+ * duplicate). So a message from a session the receiver doesn't know (first one since it started, or the sender
+ * restarted) resyncs it: the reorder buffer is dropped and delivery starts over at that message's base. The sender
+ * has to pick a new session on every start (esp_random(), time(), ...): begin(session).
+ *
+ * TX:  channel.send(proto, ServoCam_ID, &req, sizeof(req), micros());     channel.service(proto, micros());  // every loop
+ * RX:  if (f.id == kReliableId || f.id == kAckId) channel.onFrame(f.id, f.payload.data(), f.length, deliver);
+ *      then send the ACK: channel.service(proto, ...) does it, or takeAck() if RX and TX live on different tasks.
+*****************************************************************************************************************************/
+
+/* Protocol level IDs live at the top of the ID space (see Superframe.hpp / FlowControl.hpp) */
+constexpr uint8_t kReliableId = 0xF2;
+constexpr uint8_t kAckId = 0xF3;
+constexpr uint16_t kReliableHeader = 4;    // seq + base + session + id
+constexpr uint16_t kAckPayload = 6;        // cum + session + sack
+
+struct ReliableStats {
+    uint32_t sent = 0;          // messages accepted by send()
+    uint32_t retransmits = 0;
+    uint32_t acked = 0;
+    uint32_t failed = 0;        // given up after maxRetries
+    uint32_t delivered = 0;     // receiver: handed to the application
+    uint32_t duplicates = 0;    // receiver: already had it (our ACK got lost)
+    uint32_t skipped = 0;       // receiver: the sender gave up on it, never delivered
+    uint32_t resyncs = 0;       // receiver: started over on a new session (first message, or the sender restarted)
+};
+
+/**
+ * @tparam MaxMessage: biggest inner payload (the frame carries MaxMessage + kReliableHeader)
+ * @tparam Window: messages in flight / in the reorder buffer, power of two up to 32 (SACK bitmap)
+ */
+template <std::size_t MaxMessage, std::size_t Window = 8>
+class ReliableChannel {
+    static_assert(Window >= 2 && Window <= 32, "window has to fit the 32 bit SACK bitmap");
+    static_assert((Window & (Window - 1)) == 0, "window must be a power of two (seq wraps at 256)");
+    static_assert(MaxMessage + kReliableHeader <= 255, "reliable messages are small by design");
+
+public:
+    /** @param rtoUs: resend a message not ACKed after this long. @param maxRetries: then give up on it */
+    void configure(uint32_t rtoUs, uint8_t maxRetries) {
+        rtoUs_ = rtoUs;
+        maxRetries_ = maxRetries;
+    }
+
+    /** Start over (both sides): nothing in flight, nothing waiting. @param session: ours as a sender, has to differ
+     * from the previous start's so the receiver notices the restart */
+    void begin(uint8_t session) {
+        for (Out &o : out_) o = Out{};
+        for (In &i : in_) i.have = false;
+        base_ = next_ = expected_ = 0;
+        session_ = session;
+        synced_ = false;
+        ackPending_ = false;
+    }
+
+    /****************************** Sender side ******************************/
+
+    /** Send one message reliably. @param tx: anything with send(id, payload, len) (SerialProtocol, TransportMux, ...)
+     * @return false if the window is full (or the message too big), nothing was sent */
+    template <typename Tx>
+    bool send(Tx &tx, uint8_t id, const void *payload, uint8_t len, uint32_t nowUs) {
+        if (len > MaxMessage || inFlight() == Window) return false;
+        Out &o = out_[next_ % Window];
+        o.seq = next_++;
+        o.id = id;
+        o.len = len;
+        std::memcpy(o.payload, payload, len);
+        o.acked = false;
+        o.hole = false;
+        o.fastDone = false;
+        o.retries = 0;
+        ++stats_.sent;
+        transmit(tx, o, nowUs);
+        return true;
+    }
+
+    /** Resend what timed out, give up on what ran out of retries, and send the pending ACK (if any) */
+    template <typename Tx>
+    void service(Tx &tx, uint32_t nowUs) {
+        for (uint8_t s = base_; s != next_; ++s) {
+            Out &o = out_[s % Window];
+            if (o.acked) continue;
+            if (o.hole) {                           // fast retransmit, doesn't count against maxRetries
+                o.hole = false;
+                o.fastDone = true;
+                ++stats_.retransmits;
+                transmit(tx, o, nowUs);
+                continue;
+            }
+            if (nowUs - o.sentUs < rtoUs_) continue;
+            if (o.retries >= maxRetries_) {
+                o.acked = true;                 // give up, base moves past it and tells the receiver
+                ++stats_.failed;
+                continue;
+            }
+            ++o.retries;
+            o.fastDone = false;
+            ++stats_.retransmits;
+            transmit(tx, o, nowUs);
+        }
+        slide();
+
+        uint8_t ack[kAckPayload];
+        if (takeAck(ack)) tx.send(kAckId, ack, kAckPayload);
+    }
+
+    /** Messages sent and not ACKed (nor given up) yet */
+    std::size_t inFlight() const { return static_cast<uint8_t>(next_ - base_); }
+
+    /****************************** Receiver side ******************************/
+
+    /** Feed a received frame. Reliable messages are delivered in order as deliver(id, payload, len), ACKs update
+     * the sender side. @return false if the frame is not for the channel (not kReliableId / kAckId) */
+    template <typename Deliver>
+    bool onFrame(uint8_t id, const uint8_t *p, uint16_t len, Deliver &&deliver) {
+        if (id == kAckId) {
+            if (len == kAckPayload) onAck(p);
+            return true;
+        }
+        if (id != kReliableId) return false;
+        if (len < kReliableHeader || static_cast<std::size_t>(len - kReliableHeader) > MaxMessage) return true;
+
+        const uint8_t seq = p[0];
+        const uint8_t base = p[1];
+        const uint8_t session = p[2];
+        ackPending_ = true;
+
+        /* New session: whatever we had is from a sender that no longer exists, start over at its base */
+        if (!synced_ || session != peerSession_) {
+            for (In &i : in_) i.have = false;
+            expected_ = base;
+            peerSession_ = session;
+            synced_ = true;
+            ++stats_.resyncs;
+        }
+
+        /* The sender gave up on some messages, don't wait for them anymore */
+        const uint8_t skip = static_cast<uint8_t>(base - expected_);
+        if (skip > 0 && skip <= Window) {
+            for (uint8_t i = 0; i < skip; ++i) {
+                In &slot = in_[expected_ % Window];
+                if (slot.have) deliverSlot(slot, deliver);
+                else ++stats_.skipped;
+                ++expected_;
+            }
+        }
+
+        const uint8_t d = static_cast<uint8_t>(seq - expected_);
+        if (d >= Window) {                      // before the window = already delivered, our ACK got lost
+            ++stats_.duplicates;
+            return true;
+        }
+        In &slot = in_[seq % Window];
+        if (slot.have) {
+            ++stats_.duplicates;
+        } else {
+            slot.have = true;
+            slot.id = p[3];
+            slot.len = static_cast<uint8_t>(len - kReliableHeader);
+            std::memcpy(slot.payload, p + kReliableHeader, slot.len);
+        }
+
+        while (in_[expected_ % Window].have) {
+            deliverSlot(in_[expected_ % Window], deliver);
+            ++expected_;
+        }
+        return true;
+    }
+
+    /** Build the ACK for what was received so far, once per batch of received messages.
+     * @return false if there is nothing new to ACK */
+    bool takeAck(uint8_t *out) {
+        if (!ackPending_) return false;
+        ackPending_ = false;
+        uint32_t sack = 0;
+        for (uint8_t i = 0; i + 1U < Window; ++i) {
+            if (in_[static_cast<uint8_t>(expected_ + 1 + i) % Window].have) sack |= 1UL << i;
+        }
+        out[0] = expected_;
+        out[1] = peerSession_;
+        std::memcpy(out + 2, &sack, sizeof(sack));
+        return true;
+    }
+
+    const ReliableStats &stats() const { return stats_; }
+
+private:
+    struct Out {
+        uint8_t seq, id, len, retries;
+        bool acked;
+        bool hole;              // a later message was SACKed, resend at the next service()
+        bool fastDone;          // already fast-retransmitted since the last RTO
+        uint32_t sentUs;
+        uint8_t payload[MaxMessage];
+    };
+    struct In {
+        bool have;
+        uint8_t id, len;
+        uint8_t payload[MaxMessage];
+    };
+
+    Out out_[Window]{};
+    In in_[Window]{};
+    uint8_t base_ = 0;          // oldest unacked
+    uint8_t next_ = 0;          // next seq to use
+    uint8_t expected_ = 0;      // receiver: next seq to deliver
+    uint8_t session_ = 0;       // ours, in every message we send
+    uint8_t peerSession_ = 0;   // receiver: the sender's, valid once synced_
+    bool synced_ = false;
+    bool ackPending_ = false;
+    uint32_t rtoUs_ = 50000;
+    uint8_t maxRetries_ = 10;
+    ReliableStats stats_{};
+
+    template <typename Tx>
+    void transmit(Tx &tx, Out &o, uint32_t nowUs) {
+        uint8_t frame[MaxMessage + kReliableHeader];
+        frame[0] = o.seq;
+        frame[1] = base_;
+        frame[2] = session_;
+        frame[3] = o.id;
+        std::memcpy(frame + kReliableHeader, o.payload, o.len);
+        tx.send(kReliableId, frame, static_cast<uint16_t>(o.len + kReliableHeader));
+        o.sentUs = nowUs;                       // a send refused by the link just waits for the next RTO
+    }
+
+    void onAck(const uint8_t *p) {
+        if (p[1] != session_) return;           // ACKs a previous life of ours
+        const uint8_t cum = p[0];
+        uint32_t sack;
+        std::memcpy(&sack, p + 2, sizeof(sack));
+
+        bool later = false;     // walking backwards: some message after this one was SACKed
+        for (uint8_t s = next_; s != base_;) {
+            --s;
+            const uint8_t back = static_cast<uint8_t>(cum - s);     // s before cum: received in order
+            const uint8_t ahead = static_cast<uint8_t>(s - cum);    // s after cum: maybe in the SACK bitmap
+            const bool inCum = back >= 1 && back <= Window;
+            const bool inSack = ahead >= 1 && ahead < Window && ((sack >> (ahead - 1)) & 1U);
+            Out &o = out_[s % Window];
+            if ((inCum || inSack) && !o.acked) {
+                o.acked = true;
+                ++stats_.acked;
+            }
+            if (inSack) later = true;
+            else if (later && !o.acked && !o.fastDone) o.hole = true;
+        }
+        slide();
+    }
+
+    void slide() {
+        while (base_ != next_ && out_[base_ % Window].acked) ++base_;
+    }
+
+    template <typename Deliver>
+    void deliverSlot(In &slot, Deliver &deliver) {
+        deliver(slot.id, static_cast<const uint8_t*>(slot.payload), static_cast<uint8_t>(slot.len));
+        slot.have = false;
+        ++stats_.delivered;
+    }
+};
+
+#endif /* RELIABLE_CHANNEL_HPP */
@@ -0,0 +1,180 @@
+/**
+ * @file SPISlaveProtocol.hpp
+ * @author Eliot Abramo
+ * @brief Same frames as SerialProtocol, but over SPI with the ESP32 as slave (Raspberry Pi master @ 8 MHz).
+ * @date 2025-07-03
+ */
+#ifndef SPI_SLAVE_PROTOCOL_HPP
+#define SPI_SLAVE_PROTOCOL_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "ByteRing.hpp"
+#include "SerialProtocol.hpp"
+#include "SpiSlaveHal.hpp"
+
+/*************************************************** How to use *************************************************************
+ * The wire format, the parser and the Frame type are exactly the ones of SerialProtocol, only the transport changes.
+ *
+ * static Esp32SpiSlaveHal spiHal(SPI3_HOST, MOSI, MISO, SCLK, CS);
+ * static SPISlaveProtocol<256, 512> spiProto(spiHal);      // MaxPayload, TX ring size (power of two)
+ *
+ * setup():  spiProto.begin();
+ * loop():   spiProto.poll([](const auto &f) { handleFrame(f); });   // same callback as processBytes()
+ *           spiProto.send(PacketId, &pkt, sizeof(pkt));            // never blocks, goes out with the next transactions
+ *
+ * How it moves bytes: two DMA transactions of TxnSize bytes are always queued. The master clocks them whenever it wants
+ * (it has to poll, a slave can't talk first). Each finished transaction gives TxnSize bytes to the parser and is
+ * re-armed with the next TxnSize bytes of the TX ring, padded with 0x00 when there is nothing to say (0x00 is never a
+ * start byte, so the other side just skips it like line noise).
+ *
+ * The master is expected to always clock full TxnSize transactions. If it stops early, the rest of the TX bytes of
+ * that transaction are lost and the frame they belonged to fails its CRC on the Pi.
+ *
+ * Keep the object static (internal RAM), the DMA buffers live inside it.
+*****************************************************************************************************************************/
+
+/* Stream that only writes, into a ring. Frames are committed on flush() (SerialProtocol::send() ends with one), so the
+ * DMA side never sees half a frame, and a frame that doesn't fit is rolled back as a whole. */
+template <std::size_t RingSize>
+class RingTxStream : public Stream {
+public:
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *data, size_t len) override {
+        if (overflow_ || ring_.room() < len) {
+            overflow_ = true;
+            return 0;
+        }
+        ring_.put(data, len);
+        return len;
+    }
+    void flush() override {
+        if (overflow_) {
+            ring_.rollback();
+            overflows_.store(overflows_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            ring_.commit();
+        }
+        lastOk_ = !overflow_;
+        overflow_ = false;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    using Print::write;
+
+    ByteRing<RingSize> &ring() { return ring_; }
+    const ByteRing<RingSize> &ring() const { return ring_; }
+    bool lastOk() const { return lastOk_; }
+    uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    ByteRing<RingSize> ring_;
+    bool overflow_ = false;
+    bool lastOk_ = true;
+    std::atomic<uint32_t> overflows_{0};    // TX task writes, stats() may read it from the RX task
+};
+
+template <std::size_t MaxPayload, std::size_t RingSize, std::size_t TxnSize = 64, typename Crc = Crc16Table>
+class SPISlaveProtocol {
+    static_assert(TxnSize % 4 == 0, "DMA transactions have to be a multiple of 4 bytes");
+    static_assert(RingSize >= MaxPayload + 7, "TX ring must hold at least one full frame");
+
+public:
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Stats = ProtocolStats;
+    using Parser = SerialProtocol<MaxPayload, Crc>;
+
+    explicit SPISlaveProtocol(SpiSlaveHal &hal) : hal_(hal), proto_(tx_) {}
+
+    /** Bring up the driver and arm both transactions */
+    bool begin() {
+        if (!hal_.begin(TxnSize)) return false;
+        for (uint8_t slot = 0; slot < kSlots; ++slot) {
+            if (!arm(slot)) return false;
+        }
+        return true;
+    }
+
+    /** Queue a frame, same rules as SerialProtocol::send().
+     * @return false if it was dropped (bad size, or the TX ring is full -> whole frame dropped, see stats()) */
+    bool send(uint8_t id, const void *payload, uint16_t len) {
+        return proto_.send(id, payload, len) && tx_.lastOk();
+    }
+    template <std::size_t Capacity>
+    bool send(const SuperframeBuilder<Capacity> &sf) {
+        return proto_.send(sf) && tx_.lastOk();
+    }
+
+    /** Would send() take a frame of len payload bytes right now? (see SerialProtocol::canQueue()) */
+    bool canQueue(uint16_t len) const {
+        return len > 0 && len <= MaxPayload && tx_.ring().room() >= Parser::kFrameOverhead + len;
+    }
+
+    /** Collect finished transactions, parse what the master sent and re-arm them with pending TX bytes.
+     * @param onFrame: called as onFrame(const Frame&) for every valid frame (same as processBytes())
+     * @return number of valid frames received
+     */
+    template <typename OnFrame>
+    std::size_t poll(OnFrame &&onFrame) {
+        std::size_t frames = 0;
+        uint8_t slot = 0;
+        std::size_t received = 0;
+        while (hal_.finished(&slot, &received)) {
+            if (slot >= kSlots) continue;
+            if (received > TxnSize) received = TxnSize;
+            frames += proto_.processBytes(rxBuf_[slot], received, onFrame);
+            arm(slot);
+        }
+        return frames;
+    }
+
+    /** Health counters, same meaning as SerialProtocol (txBytes = real bytes put in transactions, padding excluded) */
+    Stats stats() const {
+        Stats st = proto_.stats();
+        st.txBytes = txBytes_;
+        st.txOverflows = tx_.overflows();
+        return st;
+    }
+
+    /** The parser underneath, for setResync() / setTimeout() */
+    Parser &parser() { return proto_; }
+
+    /** Bytes waiting for the master to come and get them */
+    std::size_t txPending() const { return tx_.ring().size(); }
+
+private:
+    static constexpr uint8_t kSlots = 2;     // one being clocked, one ready
+    static constexpr uint8_t kIdle = 0x00;   // padding when there is nothing to send
+
+    SpiSlaveHal &hal_;
+    RingTxStream<RingSize> tx_;
+    Parser proto_;
+    uint32_t txBytes_ = 0;
+    alignas(4) uint8_t txBuf_[kSlots][TxnSize]{};
+    alignas(4) uint8_t rxBuf_[kSlots][TxnSize]{};
+
+    /* Fill a slot's TX buffer from the ring (two chunks if it wraps), pad the rest and queue it */
+    bool arm(uint8_t slot) {
+        auto &ring = tx_.ring();
+        std::size_t filled = 0;
+        while (filled < TxnSize) {
+            const uint8_t *chunk = nullptr;
+            std::size_t n = ring.peek(&chunk);
+            if (n == 0) break;
+            if (n > TxnSize - filled) n = TxnSize - filled;
+            std::memcpy(&txBuf_[slot][filled], chunk, n);
+            ring.consume(n);
+            filled += n;
+        }
+        std::memset(&txBuf_[slot][filled], kIdle, TxnSize - filled);
+        txBytes_ += static_cast<uint32_t>(filled);
+        return hal_.queue(slot, txBuf_[slot], rxBuf_[slot], TxnSize);
+    }
+};
+
+#endif /* SPI_SLAVE_PROTOCOL_HPP */
@@ -9,7 +9,16 @@
 
 #include <Arduino.h>
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include "ByteRing.hpp"
+#include "Crc16.hpp"
+#include "FlowControl.hpp"
+#include "FrameQueue.hpp"
+#include "Superframe.hpp"
 
 /*************************************************** How to use *************************************************************
  * 1. Seems trivial but important, just create an instance. As an argument you can pass anything that 
@@ -17,11 +26,24 @@
  * 
  * SerialProtocol<MAX SIZE> _name(Something that inherits from Stream) <--> SerialProtocol<128> proto(Serial);
  * 
+ * Optionally you can choose how the CRC is computed (flash vs speed, see Crc16.hpp), default is the 256 entry table:
+ * 
+ * SerialProtocol<128, Crc16Bitwise> tiny(Serial);   SerialProtocol<128, Crc16Slice8> fast(Serial);
+ * 
  * 2. Send your packet (TX). You just use the send() function with your packet as an argument (which has to be less than 
  * the max you defined).
  * 
  * proto.send(PacketId, &pkt, sizeof(pkt));
  * 
+ * By default send() blocks until the frame has left the UART. If you can't afford that, give it a TX ring (3rd template
+ * argument, power of two) and call poll() every loop, send() then only copies the frame and returns:
+ * 
+ * SerialProtocol<128, Crc16Table, 512> proto(Serial);    ...    proto.send(...);  proto.poll();
+ * 
+ * Lots of small packets at the same time? Batch them in one frame with a SuperframeBuilder (Superframe.hpp):
+ * 
+ * sf.add(MassDrill_ID, &drill, sizeof(drill));  sf.add(DustData_ID, &dust, sizeof(dust));  proto.send(sf);
+ * 
  * 3. Receive packet. Now this might be clearer if you look at ERC_EL_Broco which is where I do this. But essentially, just 
  * feed the bytes one at a time.
  * 
@@ -31,7 +53,23 @@
  *  }
  * }
  * 
- * That’s it.  No dynamic allocation, no memcpy, no circular buffers.
+ * Or, if you already have a whole buffer (Stream::readBytes, DMA, ...), hand it over in one go. Every frame that
+ * completes inside the buffer is passed to the callback:
+ * 
+ * uint8_t buf[64];
+ * size_t n = Serial.readBytes(buf, min(Serial.available(), (int)sizeof(buf)));
+ * proto.processBytes(buf, n, [](const auto &f) { handleFrame(f); });
+ * 
+ * In handleFrame(), read the payload with view<T>() (empty if the length is wrong) instead of casting it:
+ * 
+ * if (auto req = f.view<ServoRequest>()) servo.set_request(*req);
+ * 
+ * 4. (Optional) If frames are parsed in one place (ISR, RX task) and handled in another, let the parser push them into a
+ * FrameQueue (see FrameQueue.hpp) instead of handling them on the spot:
+ * 
+ * proto.processByte(Serial.read(), rxFrames);   or   proto.processBytes(buf, n, rxFrames);
+ * 
+ * That’s it.  No dynamic allocation.
  * (I swear this works quite well, scouts honor).
 *****************************************************************************************************************************/
 
@@ -41,52 +79,171 @@
 *****************************************************************************************************************************/
 
 
+/* Alignment of ProtocolFrame::payload. Packets are read with memcpy, so nothing depends on it for correctness, it lets
+ * the compiler turn those copies into plain aligned loads. 8 covers any scalar a packet can hold (double, uint64),
+ * today's float/uint32 packets only need 4 */
+#ifndef SERIAL_PROTOCOL_PAYLOAD_ALIGN
+#define SERIAL_PROTOCOL_PAYLOAD_ALIGN 8
+#endif
+
+/* One received frame. Lives outside the class so every transport with the same MaxPayload (UART, SPI, ...) hands out
+ * the exact same type. */
 template <std::size_t MaxPayload>
+struct ProtocolFrame {
+    static constexpr std::size_t kMaxPayload = MaxPayload;
+    static constexpr std::size_t kPayloadAlign = SERIAL_PROTOCOL_PAYLOAD_ALIGN;
+
+    uint8_t id;                              // Packet ID (router key)
+    uint16_t length;                         // Payload size, HAS TO BE less than MaxPayload (def above)
+    alignas(kPayloadAlign) std::array<uint8_t, MaxPayload> payload; // Raw payload bytes
+
+    /** Read the payload as a T.
+     * @return empty if the length doesn't match sizeof(T) (wrong packet, or a truncated one) */
+    template <typename T>
+    std::optional<T> view() const {
+        if (length != sizeof(T)) return std::nullopt;
+        return as<T>();
+    }
+
+    /** Same as view() when you already know the length is right (e.g. after a router checked it).
+     * A copy, not a cast: the bytes were never a T (processByte() stores them one by one), reading them through a T*
+     * would break strict aliasing. For packet-sized T the memcpy compiles to the same loads a cast would. */
+    template <typename T>
+    T as() const {
+        checkPacket<T>();
+        T pkt;
+        std::memcpy(&pkt, payload.data(), sizeof(T));
+        return pkt;
+    }
+
+private:
+    template <typename T>
+    static constexpr void checkPacket() {
+        static_assert(std::is_trivially_copyable<T>::value, "packet must be trivially copyable to be read from the wire");
+        static_assert(sizeof(T) <= MaxPayload, "packet bigger than MaxPayload");
+    }
+};
+
+/* Link health, all counters only ever go up (wrap at 2^32), diff two snapshots to get rates.
+ * Slow link -> bytesIn/framesOk low but no errors. Lossy link -> crcFailures/lengthRejects/resyncs climbing. */
+struct ProtocolStats {
+    uint32_t bytesIn = 0;       // every byte fed to the parser
+    uint32_t framesOk = 0;      // frames that passed length + CRC
+    uint32_t crcFailures = 0;   // CRC mismatch, one per rejected frame (not per candidate rescanned inside it)
+    uint32_t lengthRejects = 0; // length field zero or bigger than MaxPayload + 1, same
+    uint32_t timeouts = 0;      // partial frames dropped by the inter-byte / frame timeout
+    uint32_t resyncs = 0;       // failed candidates rescanned (resync mode only)
+    uint32_t txBytes = 0;       // bytes handed to the Stream
+    uint32_t txOverflows = 0;   // frames dropped because the TX ring was full
+    uint32_t creditStalls = 0;  // frames not sent because the peer had no room for them (flow control)
+};
+
+template <std::size_t MaxPayload, typename Crc = Crc16Table, std::size_t TxBufSize = 0>
 class SerialProtocol {
+    static_assert(TxBufSize == 0 || TxBufSize >= MaxPayload + 7, "TX ring must hold at least one full frame");
+
 public:
-    struct Frame {
-        uint8_t id;                              // Packet ID (router key)
-        uint16_t length;                         // Payload size, HAS TO BE less than MaxPayload (def above)
-        std::array<uint8_t, MaxPayload> payload; // Raw payload bytes
-    };
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Stats = ProtocolStats;
+    static constexpr std::size_t kFrameOverhead = 7;   // STX1 STX2 LenLo LenHi ID ... CrcLo CrcHi
 
     /* With this you can plug in any Arduino Stream (HardwareSerial, Wire, …) which I find very cool and also very flexible */
     explicit SerialProtocol(Stream &stream) : s_(stream) {}
 
+    /* Link health counters, see ProtocolStats. The RX ones belong to whoever parses; the TX ones (txBytes, txOverflows,
+     * creditStalls) are relaxed atomics, so the RX task may call this while the TX task sends (TransportMux does) */
+    Stats stats() const {
+        Stats st = stats_;
+        st.txBytes = txBytes_.load(std::memory_order_relaxed);
+        st.txOverflows = txOverflows_.load(std::memory_order_relaxed);
+        st.creditStalls = creditStalls_.load(std::memory_order_relaxed);
+        return st;
+    }
+
     /****************************** Send ******************************
      * @brief Push an already-formed payload onto the wire.
      * @param id: application-level packet identification,these are definied in lib>Packets>packet_id.hpp 
      * @param payload: raw bytes to send 
      * @param len: it's in the name, length of packet(len ≥ 1, ≤ MaxPayload)
+     * @return true if the frame was written (or queued), false if it was dropped
      *
      * Safety guards:
-     *   – oversized or zero-length payloads are silently dropped.
-     *   – send() is synchronous; call from a low-duty loop or wrap
-     *     it in a task if you need async.
+     *   – oversized or zero-length payloads are dropped.
+     *   – TxBufSize == 0 (default): send() is synchronous, it writes the frame and flush()es, so it blocks until the
+     *     UART FIFO drains (~2 ms for a DustData at 115200). Call from a low-duty loop.
+     *   – TxBufSize > 0: the whole frame is serialized into the static TX ring and send() returns straight away, the
+     *     bytes go out in poll(). Overflow policy: if the whole frame doesn't fit, the NEW frame is dropped (never a
+     *     partial frame on the wire, never blocks) and counted in stats().txOverflows.
+     *   – flow control on (setFlowControl()): a frame the peer has no room for is not sent, returns false and is
+     *     counted in stats().creditStalls.
      */
-    void send(uint8_t id, const void *payload, uint16_t len) {
-        if (len > MaxPayload || len == 0) return;   // drop oversized/empty packets
-        /* Start-of-frame markers as explained in comment of proccessByte*/
-        write8(kStx1);
-        write8(kStx2);
-
-        /* Length = id + payload = 1 + payload */
-        write16(static_cast<uint16_t>(len + 1));
+    bool send(uint8_t id, const void *payload, uint16_t len) {
+        if (len > MaxPayload || len == 0) return false;   // drop oversized/empty packets
+        if (flow_) {
+            if (!credit_.canSend()) {
+                bump(creditStalls_, 1);                    // peer is full, hold back (caller decides to retry or drop)
+                return false;
+            }
+            if (!write(id, payload, len)) return false;
+            credit_.onSent();
+            return true;
+        }
+        return write(id, payload, len);
+    }
 
-        /* ID byte */
-        write8(id);
+    /** Would send() take a frame of len payload bytes right now (size ok, peer has credit, TX ring has room)?
+     * Lets a bulk sender (Fragmentation.hpp) wait for room instead of overflowing the ring. Unbuffered TX always can.
+     */
+    bool canQueue(uint16_t len) const {
+        if (len > MaxPayload || len == 0) return false;
+        if (flow_ && !credit_.canSend()) return false;
+        if constexpr (TxBufSize == 0) return true;
+        else return txRing_.room() >= kFrameOverhead + len;
+    }
 
-        /* Raw payload */
-        const uint8_t* p = static_cast<const uint8_t*>(payload);
-        s_.write(p, len);
+    /** Send a whole batch of records in one frame (see Superframe.hpp). A batch with a single record goes out as a
+     * normal frame, it's cheaper and the other side doesn't have to know about superframes for it.
+     * @return true if the frame was written (or queued), an empty batch is a no-op and returns true
+     */
+    template <std::size_t Capacity>
+    bool send(const SuperframeBuilder<Capacity> &sf) {
+        static_assert(Capacity <= MaxPayload, "superframe bigger than MaxPayload");
+        if (sf.empty()) return true;
+        if (sf.count() == 1) return send(sf.data()[0], sf.data() + kRecordOverhead, sf.data()[1]);
+        return send(kSuperframeId, sf.data(), sf.size());
+    }
 
-        /* CRC (calculated over ID+payload) */
-        write16(crc16(id, p, len));
+    /** Buffered TX only (TxBufSize > 0): move as many queued bytes as the UART can take WITHOUT blocking.
+     * Call it every loop() (or from a TX-empty hook). Relies on Stream::availableForWrite(), which HardwareSerial has.
+     * @return number of bytes handed to the Stream
+     */
+    std::size_t poll() {
+        if constexpr (TxBufSize == 0) {
+            return 0;
+        } else {
+            std::size_t sent = 0;
+            for (;;) {
+                const uint8_t *chunk = nullptr;
+                std::size_t n = txRing_.peek(&chunk);
+                const int room = s_.availableForWrite();
+                if (n == 0 || room <= 0) break;
+                if (n > static_cast<std::size_t>(room)) n = static_cast<std::size_t>(room);
+                n = s_.write(chunk, n);
+                if (n == 0) break;
+                txRing_.consume(n);
+                sent += n;
+                bump(txBytes_, static_cast<uint32_t>(n));
+            }
+            return sent;
+        }
+    }
 
-        /* Make sure everything actually leaves the HW FIFO. Made for some wierd debugging lol */
-        s_.flush();
+    /** Bytes still waiting in the TX ring (always 0 in synchronous mode) */
+    std::size_t txPending() const {
+        if constexpr (TxBufSize == 0) return 0;
+        else return txRing_.size();
     }
-    
+
     /** Ok, I am going to do my best to explain how this works but I understand that it can be daunting 
      * by looking at it. If you have any questions feel free to send me a message on slack @Eliot Abramo. 
      * 
@@ -116,7 +273,11 @@ public:
      * 
      * - If there's a payload, it reads that in, otherwise skips to CRC. (CRC <-> check if packet isn't compromise)
      * 
-     * - Finally, it reads the CRC (2 bytes) and checks if it matches what we expect.
+     * - Finally, it reads the CRC (2 bytes) and checks if it matches what we expect. The expected CRC is updated as
+     * each ID/payload byte comes in (one table lookup), so the last byte costs the same as any other byte and there
+     * is no latency spike at the end of a frame. Worst case per byte is one switch case + one lookup
+     * (test/parser_byte_cost.cpp times every byte position: ~7 ns typical, ~30 ns worst on a PC, where the old
+     * end-of-frame CRC cost ~450 ns for a 127 B payload).
      * 
      * - If everything checks out, it fills in the frame and returns true.
      * 
@@ -124,16 +285,99 @@ public:
      * 
      */    
 
-     bool processByte(uint8_t b) {
+    bool processByte(uint8_t b) {
+        timeoutBegin();
+        ++stats_.bytesIn;
+        const bool done = resync_ ? feedResync(b, IgnoreFrame{}) > 0     // frame() holds the last completed one
+                                  : step(b) == Verdict::Done;
+        timeoutEnd();
+        return done;
+    }
+
+    /** Clock used for timeouts, in µs. Arduino's micros() on target, anything you like on the host (tests). */
+    using ClockFn = unsigned long (*)();
+
+    /** Timeouts. If a frame gets cut off (MCU reset mid-send, cable wiggle), without this the parser sits in Payload
+     * and eats the start of the NEXT frame as payload, costing at least one more frame. With it, a partial frame is
+     * dropped (back to 0xA5 hunt) when the next byte arrives too late, before that byte is parsed.
+     * @param interByteUs: max gap between two bytes of the same frame, 0 = off
+     * @param frameUs: max time for a whole frame from its 0xA5, 0 = off
+     * @param clock: µs clock, injectable so this can be tested on the host
+     * Every drop is counted in stats().timeouts. Call checkTimeout() if you also want to expire frames while idle.
+     */
+    void setTimeout(uint32_t interByteUs, uint32_t frameUs = 0, ClockFn clock = micros) {
+        interByteUs_ = interByteUs;
+        frameUs_ = frameUs;
+        clock_ = clock;
+        lastByteUs_ = frameStartUs_ = static_cast<uint32_t>(clock_());
+    }
+
+    /** Drop the partial frame if it has expired, without feeding a byte.
+     * @return true if something was dropped */
+    bool checkTimeout() {
+        if (interByteUs_ == 0 && frameUs_ == 0) return false;
+        return expire(static_cast<uint32_t>(clock_()));
+    }
+
+    /** Resync mode. Off (default): when a length or CRC check fails, every byte of the bad candidate is thrown away
+     * and we hunt for the next 0xA5, so a real frame that started INSIDE those bytes is lost too (one corrupted byte
+     * can cost 2-3 frames on a noisy harness).
+     * On: the bytes of the failed candidate are kept and rescanned for the next 0xA5 0x5A, so nothing that could
+     * still be a valid frame is discarded. Costs a bit more RAM (2 max-size frames) and a failure replays at most one
+     * frame worth of bytes. In this mode processBytes() goes byte per byte (no memchr/memcpy fast paths) and if a
+     * replay completes several frames at once, processByte() only keeps the last one in frame(), use processBytes()
+     * or a FrameQueue to get all of them.
+     */
+    void setResync(bool on) {
+        resync_ = on;
+        reset();
+        winStart_ = winCur_ = winEnd_ = rejectEnd_ = 0;
+    }
+    bool resync() const { return resync_; }
+
+    /** Credit-based flow control (FlowControl.hpp), BOTH sides have to turn it on. Then:
+     *   - send() only sends while the peer has advertised room, otherwise returns false (stats().creditStalls).
+     *     Nothing goes out before the peer's first credit frame.
+     *   - credit frames (kCreditId) are consumed here, they never reach the application.
+     *   - the receiving side has to call updateCredit() regularly (TX side, it sends).
+     * @param advertStep: a new credit frame goes out once the grant grew by this many frames
+     * @param keepaliveUs: the grant is re-sent at least this often (heals lost credit frames)
+     */
+    void setFlowControl(bool on, uint16_t advertStep = 2, uint32_t keepaliveUs = 100000) {
+        flow_ = on;
+        credit_.configure(advertStep, keepaliveUs);
+    }
+    bool flowControl() const { return flow_; }
+
+    /** Tell the peer how many more frames we can take (free RX slots, e.g. queue.capacity() - queue.size()).
+     * Cheap to call every loop, a credit frame only goes out when it's worth it (see setFlowControl()).
+     * @return true if a credit frame was sent */
+    bool updateCredit(uint16_t freeSlots) {
+        if (!flow_) return false;
+        uint8_t payload[kCreditPayload];
+        if (!credit_.advert(freeSlots, static_cast<uint32_t>(clock_()), payload)) return false;
+        return write(kCreditId, payload, kCreditPayload);
+    }
+
+  private:
+    /* Outcome of one byte through the state machine */
+    enum class Verdict : uint8_t { More, Done, Fail };
+
+    /* The actual state machine (see above) */
+    Verdict step(uint8_t b) {
         switch (state_) {
             /**** 0xA5 hunt ****/
             case State::Stx1:
-                if (b == kStx1) state_ = State::Stx2;
+                if (b == kStx1) {
+                    state_ = State::Stx2;
+                    frameStartUs_ = nowUs_;                 // whole-frame timeout counts from here
+                }
                 break;
 
             /**** 0x5A confirmation ****/
             case State::Stx2:
-                state_ = (b == kStx2) ? State::LenLo : State::Stx1;
+                if (b == kStx2) state_ = State::LenLo;
+                else if (b != kStx1) state_ = State::Stx1;    // 0xA5 0xA5 0x5A is still a valid start
                 break;
 
             /**** length low byte ****/
@@ -146,7 +390,11 @@ public:
             case State::LenHi:
                 len_ |= static_cast<uint16_t>(b) << 8;
                 // sanity check
-                if (len_ == 0 || len_ > MaxPayload + 1) { reset(); break; }
+                if (len_ == 0 || len_ > MaxPayload + 1) {
+                    if (!rescan_) ++stats_.lengthRejects;
+                    reset();
+                    return Verdict::Fail;
+                }
                 bytes_ = 0;                     // new payload counter
                 state_ = State::Id;
                 break;
@@ -154,6 +402,7 @@ public:
             /**** packet ID ****/
             case State::Id:
                 frame_.id = b;
+                crc_ = Crc::update(Crc::kInit, b);
                 bytes_ = 0;
                 state_ = (len_ == 1) ? State::CrcLo : State::Payload;
                 break;
@@ -161,6 +410,7 @@ public:
             /**** payload stream ****/
             case State::Payload:
                 frame_.payload[bytes_++] = b;
+                crc_ = Crc::update(crc_, b);
                 if (bytes_ == len_ - 1) state_ = State::CrcLo;
                 break;
 
@@ -173,16 +423,65 @@ public:
             /**** CRC16 MSB & verdict ****/
             case State::CrcHi:
                 crcRead_ |= static_cast<uint16_t>(b) << 8;
-                if (crcRead_ == crc16(frame_.id, frame_.payload.data(), len_ - 1)) {
+                if (crcRead_ == crc_) {                  // already accumulated, O(1) verdict
                     frame_.length = len_ - 1;  // strip ID
+                    ++stats_.framesOk;
                     reset();                   // ready for next frame
-                    return true;               // success!
+                    if (flow_) {
+                        if (frame_.id == kCreditId) {      // control frame, swallowed here
+                            credit_.onCredit(frame_.payload.data(), frame_.length, static_cast<uint32_t>(clock_()));
+                            return Verdict::More;
+                        }
+                        credit_.onData();
+                    }
+                    return Verdict::Done;      // success!
                 }
                 /* CRC mismatch -> drop frame and resync */
+                if (!rescan_) ++stats_.crcFailures;
                 reset();
-                break;
+                return Verdict::Fail;
+        }
+        return Verdict::More;                  // frame not yet finished
+    }
+
+  public:
+    /** Bulk version of processByte(), same state machine but much cheaper per byte on big buffers:
+     * - while hunting for 0xA5, memchr() skips the noise instead of going through the switch byte by byte.
+     * - payload runs are copied with a single memcpy and the CRC is updated over the whole run.
+     * - everything else (header, ID, CRC) goes through the byte state machine as usual.
+     *
+     * @param data: raw bytes from the wire
+     * @param len: how many of them
+     * @param onFrame: called as onFrame(const Frame&) for every valid frame, the reference is only valid during the call
+     * @return number of valid frames found in the buffer
+     *
+     * State is kept between calls, so frames can be split across buffers however the UART feels like it.
+     */
+    template <typename OnFrame>
+    std::size_t processBytes(const uint8_t *data, std::size_t len, OnFrame &&onFrame) {
+        timeoutBegin();                                 // one clock read per buffer, not per byte
+        stats_.bytesIn += static_cast<uint32_t>(len);
+        std::size_t frames = 0;
+        if (resync_) {
+            for (std::size_t i = 0; i < len; ++i) {
+                frames += feedResync(data[i], onFrame);
+            }
+        } else {
+            frames = scan(data, len, onFrame);
         }
-        return false;                          // frame not yet finished
+        timeoutEnd();
+        return frames;
+    }
+
+    /** Same as processByte() but a completed frame is pushed into a FrameQueue instead of waiting in frame().
+     * Use this from the ISR / RX task, the application pops the frames whenever it wants.
+     * @return true if a frame was completed (it may still have been dropped if the queue was full, see dropped())
+     */
+    template <std::size_t Depth>
+    bool processByte(uint8_t b, FrameQueue<Frame, Depth> &queue) {
+        if (!processByte(b)) return false;
+        queue.push(frame_);
+        return true;
     }
 
     /** Grab the last good frame.
@@ -198,6 +497,11 @@ public:
 
     static constexpr uint8_t kStx1 = 0xA5; // start token 1
     static constexpr uint8_t kStx2 = 0x5A; // start token 2
+    static constexpr std::size_t kHeaderSize = 5;  // STX1 STX2 LenLo LenHi ID
+    static constexpr std::size_t kTrailerSize = 2; // CrcLo CrcHi
+
+    struct NoTxRing {};
+    using TxRing = typename std::conditional<(TxBufSize > 0), ByteRing<TxBufSize>, NoTxRing>::type;
 
     Stream &s_; // wire abstraction
     Frame frame_{}; // rolling RX buffer
@@ -205,32 +509,188 @@ public:
     uint16_t len_ = 0; // expected (id+payload) length
     uint16_t bytes_ = 0; // payload bytes read so far
     uint16_t crcRead_ = 0; // CRC from wire
+    uint16_t crc_ = Crc::kInit; // CRC accumulated over ID+payload so far
+    TxRing txRing_{}; // buffered TX only, whole frames waiting for poll()
+    bool resync_ = false; // lookahead resync on/off
+    std::array<uint8_t, 2 * (MaxPayload + kHeaderSize + kTrailerSize)> win_{}; // resync only, see feedResync()
+    std::size_t winStart_ = 0, winCur_ = 0, winEnd_ = 0;
+    std::size_t rejectEnd_ = 0; // resync only: end of the last rejected frame, candidates before it are rescans
+    bool rescan_ = false;       // the current candidate starts inside a rejected frame: its failure isn't counted
+    ClockFn clock_ = micros;    // timeouts, see setTimeout()
+    uint32_t interByteUs_ = 0;  // 0 = off
+    uint32_t frameUs_ = 0;      // 0 = off
+    uint32_t lastByteUs_ = 0;
+    uint32_t frameStartUs_ = 0;
+    uint32_t nowUs_ = 0;
+    bool flow_ = false;         // credit flow control on/off
+    CreditFlow credit_;
+    Stats stats_{};             // RX counters, the TX ones are below
+    std::atomic<uint32_t> txBytes_{0};
+    std::atomic<uint32_t> txOverflows_{0};
+    std::atomic<uint32_t> creditStalls_{0};
+
+    /* Only the TX side writes these: load + store, no read-modify-write needed */
+    static void bump(std::atomic<uint32_t> &c, uint32_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /* Frame + write / queue, no flow control check (control frames go straight through here) */
+    bool write(uint8_t id, const void *payload, uint16_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(payload);
+
+        /* Start-of-frame markers as explained in comment of proccessByte, length = id + payload = 1 + payload, ID */
+        const uint16_t wireLen = static_cast<uint16_t>(len + 1);
+        const uint8_t header[kHeaderSize] = {kStx1, kStx2, lo(wireLen), hi(wireLen), id};
+
+        /* CRC (calculated over ID+payload) */
+        const uint16_t crc = crc16(id, p, len);
+        const uint8_t trailer[kTrailerSize] = {lo(crc), hi(crc)};
+
+        if constexpr (TxBufSize == 0) {
+            s_.write(header, sizeof(header));
+            s_.write(p, len);
+            s_.write(trailer, sizeof(trailer));
+            bump(txBytes_, static_cast<uint32_t>(sizeof(header) + len + sizeof(trailer)));
+
+            /* Make sure everything actually leaves the HW FIFO. Made for some wierd debugging lol */
+            s_.flush();
+        } else {
+            if (txRing_.room() < sizeof(header) + len + sizeof(trailer)) {
+                bump(txOverflows_, 1);
+                return false;
+            }
+            txRing_.put(header, sizeof(header));
+            txRing_.put(p, len);
+            txRing_.put(trailer, sizeof(trailer));
+            txRing_.commit();
+            poll();                                     // push out whatever fits right now
+        }
+        return true;
+    }
+
+    /* Bulk path of processBytes() with the memchr/memcpy fast paths */
+    template <typename OnFrame>
+    std::size_t scan(const uint8_t *data, std::size_t len, OnFrame &onFrame) {
+        std::size_t frames = 0;
+        const uint8_t *p = data;
+        const uint8_t *end = data + len;
+
+        while (p < end) {
+            /**** 0xA5 hunt, fast path ****/
+            if (state_ == State::Stx1) {
+                const void *hit = std::memchr(p, kStx1, static_cast<std::size_t>(end - p));
+                if (hit == nullptr) break;                       // nothing but noise left
+                p = static_cast<const uint8_t*>(hit) + 1;
+                state_ = State::Stx2;
+                frameStartUs_ = nowUs_;
+                continue;
+            }
+
+            /**** payload stream, fast path ****/
+            if (state_ == State::Payload) {
+                std::size_t run = static_cast<std::size_t>(len_ - 1 - bytes_);
+                if (run > static_cast<std::size_t>(end - p)) run = static_cast<std::size_t>(end - p);
+                std::memcpy(&frame_.payload[bytes_], p, run);
+                crc_ = Crc::update(crc_, p, run);
+                bytes_ += static_cast<uint16_t>(run);
+                p += run;
+                if (bytes_ == len_ - 1) state_ = State::CrcLo;
+                continue;
+            }
+
+            /**** header / ID / CRC, slow path ****/
+            if (step(*p++) == Verdict::Done) {
+                ++frames;
+                onFrame(static_cast<const Frame&>(frame_));
+            }
+        }
+        return frames;
+    }
+
+    struct IgnoreFrame { void operator()(const Frame &) const {} };
+
+    /* Resync mode: push one byte through the state machine, keeping the raw bytes of the current candidate in win_.
+     *   win_[winStart_, winCur_)  bytes of the candidate being parsed (starts with its 0xA5)
+     *   win_[winCur_, winEnd_)    bytes still to (re)parse
+     * On a failed candidate everything after its 0xA5 goes back to "to parse" and we rescan from there. A 0xA5 0x5A
+     * found in those bytes that fails too is part of the same bad frame: it counts as a resync, not as another
+     * CRC / length failure.
+     * Returns the number of frames completed (a replay can complete more than one). */
+    template <typename OnFrame>
+    std::size_t feedResync(uint8_t b, OnFrame &&onFrame) {
+        if (winEnd_ == win_.size()) {                      // out of room, slide the live part to the front
+            const std::size_t live = winEnd_ - winStart_;
+            std::memmove(win_.data(), win_.data() + winStart_, live);
+            winCur_ -= winStart_;
+            rejectEnd_ = rejectEnd_ > winStart_ ? rejectEnd_ - winStart_ : 0;
+            winStart_ = 0;
+            winEnd_ = live;
+        }
+        win_[winEnd_++] = b;
+
+        std::size_t frames = 0;
+        while (winCur_ < winEnd_) {
+            const bool hunting = (state_ == State::Stx1);
+            if (hunting) rescan_ = winCur_ < rejectEnd_;
+            const Verdict v = step(win_[winCur_]);
+            if (hunting) winStart_ = winCur_;              // candidate (if any) starts at this byte
+            ++winCur_;
+
+            if (v == Verdict::Done) {
+                onFrame(static_cast<const Frame&>(frame_));
+                ++frames;
+                winStart_ = winCur_;
+            } else if (v == Verdict::Fail) {
+                ++stats_.resyncs;
+                if (!rescan_) rejectEnd_ = winCur_;
+                winCur_ = winStart_ + 1;                    // rescan everything after the bad candidate's 0xA5
+                winStart_ = winCur_;
+            } else if (state_ == State::Stx1) {
+                winStart_ = winCur_;                        // still hunting, nothing to keep
+            }
+        }
+        if (winStart_ == winEnd_) winStart_ = winCur_ = winEnd_ = rejectEnd_ = 0;
+        return frames;
+    }
+
+    /* Timeout bookkeeping around a byte / a buffer. Begin reads the clock into nowUs_ and drops an expired partial
+     * frame, end stamps the last byte. A frame's start is stamped with nowUs_ where the parser leaves Stx1, so a frame
+     * that starts in the middle of a buffer gets its own start time. No-ops (no clock read) when timeouts are off. */
+    void timeoutBegin() {
+        if (interByteUs_ == 0 && frameUs_ == 0) return;
+        nowUs_ = static_cast<uint32_t>(clock_());
+        expire(nowUs_);
+    }
+    void timeoutEnd() {
+        if (interByteUs_ == 0 && frameUs_ == 0) return;
+        lastByteUs_ = nowUs_;
+    }
+    bool expire(uint32_t now) {
+        if (state_ == State::Stx1) return false;
+        const bool gap = interByteUs_ != 0 && now - lastByteUs_ > interByteUs_;
+        const bool slow = frameUs_ != 0 && now - frameStartUs_ > frameUs_;
+        if (!gap && !slow) return false;
+        ++stats_.timeouts;
+        reset();
+        winStart_ = winCur_ = winEnd_ = rejectEnd_ = 0; // resync window too, those bytes are stale
+        return true;
+    }
 
     /* Reset parser to STX hunt */
     void reset() {
         state_ = State::Stx1;
         len_ = bytes_ = crcRead_ = 0;
+        crc_ = Crc::kInit;
     }
 
-    /* One-byte helpers (little-endian) */
-    void write8(uint8_t v) {
-        s_.write(v); 
-    }
-    void write16(uint16_t v) {
-        s_.write(static_cast<uint8_t>(v & 0xFF));
-        s_.write(static_cast<uint8_t>((v >> 8) & 0xFF));
-    }
+    /* Little-endian helpers */
+    static constexpr uint8_t lo(uint16_t v) { return static_cast<uint8_t>(v & 0xFF); }
+    static constexpr uint8_t hi(uint16_t v) { return static_cast<uint8_t>((v >> 8) & 0xFF); }
 
-    static uint16_t updateCrc(uint16_t crc, uint8_t b) {
-        crc ^= b;
-        for (uint8_t i = 0; i < 8; ++i) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
-        return crc;
-    }
+    /* CRC over ID + payload, the actual algorithm is the Crc policy (see Crc16.hpp) */
     static uint16_t crc16(uint8_t id, const uint8_t *data, uint16_t len) {
-        uint16_t crc = 0xFFFF;
-        crc = updateCrc(crc, id);
-        for (uint16_t i = 0; i < len; ++i) crc = updateCrc(crc, data[i]);
-        return crc;
+        uint16_t crc = Crc::update(Crc::kInit, id);
+        return Crc::update(crc, data, len);
     }
 };
 
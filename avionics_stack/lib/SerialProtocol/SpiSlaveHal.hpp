@@ -0,0 +1,93 @@
+/**
+ * @file SpiSlaveHal.hpp
+ * @author Eliot Abramo
+ * @brief Thin hardware layer under SPISlaveProtocol: queue full-duplex DMA transactions, collect the finished ones.
+ * @date 2025-07-03
+ */
+#ifndef SPI_SLAVE_HAL_HPP
+#define SPI_SLAVE_HAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The master (Raspberry Pi) decides when bytes move, the slave can only have buffers ready. So the HAL is just:
+ *   queue()    -> hand a TX and an RX buffer to the driver for the next transaction(s)
+ *   finished() -> non-blocking, which queued transaction is done and how many bytes the master actually clocked
+ *
+ * Buffers stay owned by the caller and must not be touched between queue() and finished() for that slot.
+ * Anything that implements this works: the ESP32 driver below, or a host mock that replays captured transactions.
+ */
+class SpiSlaveHal {
+public:
+    virtual ~SpiSlaveHal() {}
+
+    /** @param maxTransfer: biggest transaction that will be queued, in bytes */
+    virtual bool begin(std::size_t maxTransfer) = 0;
+
+    /** Queue one transaction. @param slot: caller's tag, given back by finished() */
+    virtual bool queue(uint8_t slot, const uint8_t *tx, uint8_t *rx, std::size_t len) = 0;
+
+    /** @return true if a transaction finished, *slot is its tag and *received the bytes clocked by the master */
+    virtual bool finished(uint8_t *slot, std::size_t *received) = 0;
+};
+
+#ifdef ESP_PLATFORM
+#include "driver/spi_slave.h"
+
+/**
+ * ESP32 SPI slave driver (DMA). The buffers handed to queue() must be 32-bit aligned, in internal RAM and a multiple
+ * of 4 bytes long, SPISlaveProtocol takes care of that.
+ */
+class Esp32SpiSlaveHal : public SpiSlaveHal {
+public:
+    Esp32SpiSlaveHal(spi_host_device_t host, int mosi, int miso, int sclk, int cs, uint8_t mode = 0)
+        : host_(host), mosi_(mosi), miso_(miso), sclk_(sclk), cs_(cs), mode_(mode) {}
+
+    bool begin(std::size_t maxTransfer) override {
+        spi_bus_config_t bus = {};
+        bus.mosi_io_num = mosi_;
+        bus.miso_io_num = miso_;
+        bus.sclk_io_num = sclk_;
+        bus.quadwp_io_num = -1;
+        bus.quadhd_io_num = -1;
+        bus.max_transfer_sz = static_cast<int>(maxTransfer);
+
+        spi_slave_interface_config_t slave = {};
+        slave.spics_io_num = cs_;
+        slave.queue_size = kSlots;
+        slave.mode = mode_;
+
+        return spi_slave_initialize(host_, &bus, &slave, SPI_DMA_CH_AUTO) == ESP_OK;
+    }
+
+    bool queue(uint8_t slot, const uint8_t *tx, uint8_t *rx, std::size_t len) override {
+        if (slot >= kSlots) return false;
+        spi_slave_transaction_t &t = trans_[slot];
+        t = {};
+        t.length = len * 8;                                  // driver counts bits
+        t.tx_buffer = tx;
+        t.rx_buffer = rx;
+        t.user = reinterpret_cast<void*>(static_cast<uintptr_t>(slot));
+        return spi_slave_queue_trans(host_, &t, 0) == ESP_OK;
+    }
+
+    bool finished(uint8_t *slot, std::size_t *received) override {
+        spi_slave_transaction_t *t = nullptr;
+        if (spi_slave_get_trans_result(host_, &t, 0) != ESP_OK || t == nullptr) return false;
+        *slot = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(t->user));
+        *received = t->trans_len / 8;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kSlots = 2;
+
+    spi_host_device_t host_;
+    int mosi_, miso_, sclk_, cs_;
+    uint8_t mode_;
+    spi_slave_transaction_t trans_[kSlots]{};
+};
+#endif /* ESP_PLATFORM */
+
+#endif /* SPI_SLAVE_HAL_HPP */
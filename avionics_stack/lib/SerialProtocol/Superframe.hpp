@@ -0,0 +1,88 @@
+/**
+ * @file Superframe.hpp
+ * @author Eliot Abramo
+ * @brief Pack several small packets into ONE SerialProtocol frame (one STX/len/CRC envelope).
+ * @date 2025-07-03
+ */
+#ifndef SUPERFRAME_HPP
+#define SUPERFRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*************************************************** How it looks *************************************************************
+ * A superframe is a normal frame whose ID is kSuperframeId. Its payload is just records glued one after the other:
+ *
+ *   +----------+-----------+------------------+----------+-----------+-----
+ *   | uint8 id | uint8 len | payload[len]     | uint8 id | uint8 len | ...
+ *   +----------+-----------+------------------+----------+-----------+-----
+ *
+ * So each packet costs 2 bytes instead of 7 (STX x2, len x2, id, CRC x2) and the whole batch shares one CRC.
+ *
+ * TX:
+ *   SuperframeBuilder<128> sf;
+ *   sf.add(MassDrill_ID, &drill, sizeof(drill));
+ *   sf.add(DustData_ID, &dust, sizeof(dust));
+ *   proto.send(kSuperframeId, sf.data(), sf.size());   sf.clear();
+ *
+ * RX:
+ *   if (f.id == kSuperframeId) forEachRecord(f.payload.data(), f.length, [](uint8_t id, const uint8_t *p, uint8_t len) {...});
+*****************************************************************************************************************************/
+
+/* Protocol level IDs live at the top of the ID space so they never collide with packet_id.hpp */
+constexpr uint8_t kSuperframeId = 0xF0;
+
+/* id + len in front of every record */
+constexpr std::size_t kRecordOverhead = 2;
+
+template <std::size_t Capacity>
+class SuperframeBuilder {
+public:
+    /** Append one record.
+     * @return false (and nothing is added) if it does not fit, send what you have and start again */
+    bool add(uint8_t id, const void *payload, uint8_t len) {
+        if (!fits(len)) return false;
+        buf_[size_++] = id;
+        buf_[size_++] = len;
+        std::memcpy(&buf_[size_], payload, len);
+        size_ += len;
+        ++count_;
+        return true;
+    }
+
+    bool fits(uint8_t len) const { return size_ + kRecordOverhead + len <= Capacity; }
+
+    const uint8_t *data() const { return buf_; }
+    uint16_t size() const { return size_; }
+    uint8_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    void clear() { size_ = 0; count_ = 0; }
+
+private:
+    uint8_t buf_[Capacity]{};
+    uint16_t size_ = 0;
+    uint8_t count_ = 0;
+};
+
+/** Walk the records of a superframe payload, fn(id, payload, len) is called for each one.
+ * A truncated last record (len pointing past the end) is ignored.
+ * @return number of records handed to fn
+ */
+template <typename Fn>
+std::size_t forEachRecord(const uint8_t *data, std::size_t len, Fn &&fn) {
+    std::size_t i = 0, n = 0;
+    while (i + kRecordOverhead <= len) {
+        const uint8_t id = data[i];
+        const uint8_t rlen = data[i + 1];
+        i += kRecordOverhead;
+        if (i + rlen > len) break;
+        fn(id, data + i, rlen);
+        i += rlen;
+        ++n;
+    }
+    return n;
+}
+
+#endif /* SUPERFRAME_HPP */
@@ -0,0 +1,382 @@
+/**
+ * @file TransportMux.hpp
+ * @author Eliot Abramo
+ * @brief Byte-level MUX: owns several transports (UART, SPI, ...), drains them fairly and sends on the healthiest one.
+ * @date 2025-07-03
+ */
+#ifndef TRANSPORT_MUX_HPP
+#define TRANSPORT_MUX_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "SerialProtocol.hpp"
+#include "SPISlaveProtocol.hpp"
+#include "Superframe.hpp"
+#include "UartPort.hpp"
+
+/*************************************************** How to use *************************************************************
+ * static StreamLink<128> uart(Serial);
+ * static SpiLink<decltype(spiProto)> spi(spiProto);
+ * static TransportMux<128> mux;
+ *
+ * setup():  mux.add(spi);  mux.add(uart);             // add order = preference, first one wins when both are fine
+ *           mux.setQuietTimeout(200);                 // a link with no valid frame for 200 ms is considered dead
+ *           mux.setErrorFailover(50, 1000);           // or 5 points more errors than the other one (1 s half-life)
+ * loop():   mux.receive([](const auto &f) { handleFrame(f); });
+ *           mux.send(PacketId, &pkt, sizeof(pkt));    // goes out on the active link
+ *           mux.service();                            // lets every link push its pending TX
+ *
+ * RX: every link is drained on every receive(), with a byte budget per link and the starting link rotating, so a
+ * flooded link can't starve the others. Nothing received is ever lost because a link is not the active one.
+ *
+ * TX: one active link. It changes when
+ *   - the active link has been quiet (no valid frame) for longer than the quiet timeout and another link is alive, or
+ *   - the active link's error rate is more than the margin above an alive link's (a lossy link that still passes
+ *     some frames never goes quiet), or
+ *   - a more preferred link is alive again and its error rate is not above the active one's.
+ * So failover from a dead link takes at most quietTimeout + one receive() period. Frames sent on the dying link during
+ * that window are lost, that's the price of not having ACKs here.
+ *
+ * Error rate = (CRC failures + length rejects + timeouts) / (those + valid frames), both counts halved every half-life,
+ * so old errors fade out and a link that got better wins its place back. A link needs kMinEvents worth of recent
+ * traffic before its rate counts against it.
+ *
+ * "Alive" means valid frames are coming in, so the other side has to talk regularly (heartbeat) on every link.
+ *
+ * receive() and send()/service() may run on two different tasks (RX task / TX task). They share the active link index
+ * and the stats() snapshot, both published by receive() without locks. Everything else of a given side stays on that
+ * side (errorRate() included, RX side only).
+*****************************************************************************************************************************/
+
+/* What the MUX needs from a transport */
+template <std::size_t MaxPayload>
+class MuxLink {
+public:
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Sink = void (*)(void *ctx, const Frame &f);
+
+    virtual ~MuxLink() {}
+
+    /** Pull and parse up to budget bytes, every valid frame goes to sink(ctx, frame). @return bytes consumed */
+    virtual std::size_t pump(std::size_t budget, Sink sink, void *ctx) = 0;
+
+    /** Queue / write one frame. @return false if dropped */
+    virtual bool send(uint8_t id, const void *payload, uint16_t len) = 0;
+
+    /** Would send() take a frame of len payload bytes right now? */
+    virtual bool canQueue(uint16_t len) const { return len > 0 && len <= MaxPayload; }
+
+    /** Push pending TX bytes, never blocks */
+    virtual void service() {}
+
+    virtual ProtocolStats stats() const = 0;
+};
+
+/* Any Arduino Stream (HardwareSerial, ...) with its own SerialProtocol */
+template <std::size_t MaxPayload, typename Crc = Crc16Table, std::size_t TxBufSize = 0>
+class StreamLink : public MuxLink<MaxPayload> {
+public:
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Sink = typename MuxLink<MaxPayload>::Sink;
+    using Parser = SerialProtocol<MaxPayload, Crc, TxBufSize>;
+
+    explicit StreamLink(Stream &stream) : s_(stream), proto_(stream) {}
+
+    std::size_t pump(std::size_t budget, Sink sink, void *ctx) override {
+        uint8_t buf[64];
+        std::size_t used = 0;
+        while (used < budget) {
+            const int avail = s_.available();
+            if (avail <= 0) break;
+            std::size_t want = static_cast<std::size_t>(avail);
+            if (want > sizeof(buf)) want = sizeof(buf);
+            if (want > budget - used) want = budget - used;
+            const std::size_t n = s_.readBytes(buf, want);
+            if (n == 0) break;
+            used += n;
+            proto_.processBytes(buf, n, [&](const Frame &f) { sink(ctx, f); });
+        }
+        return used;
+    }
+
+    bool send(uint8_t id, const void *payload, uint16_t len) override { return proto_.send(id, payload, len); }
+    bool canQueue(uint16_t len) const override { return proto_.canQueue(len); }
+    void service() override { proto_.poll(); }
+    ProtocolStats stats() const override { return proto_.stats(); }
+
+    /** The parser underneath, for setResync() / setTimeout() */
+    Parser &parser() { return proto_; }
+
+private:
+    Stream &s_;
+    Parser proto_;
+};
+
+/* Event-driven UART (UartPort.hpp): same as StreamLink but reads in bulk, and the RX task can sleep in waitRx() */
+template <std::size_t MaxPayload, typename Crc = Crc16Table, std::size_t TxBufSize = 0>
+class UartLink : public MuxLink<MaxPayload> {
+public:
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Sink = typename MuxLink<MaxPayload>::Sink;
+    using Parser = SerialProtocol<MaxPayload, Crc, TxBufSize>;
+
+    explicit UartLink(UartPort &port) : port_(port), proto_(port) {}
+
+    std::size_t pump(std::size_t budget, Sink sink, void *ctx) override {
+        uint8_t buf[64];
+        std::size_t used = 0;
+        while (used < budget) {
+            std::size_t want = sizeof(buf);
+            if (want > budget - used) want = budget - used;
+            const std::size_t n = port_.readAvailable(buf, want);
+            if (n == 0) break;
+            used += n;
+            proto_.processBytes(buf, n, [&](const Frame &f) { sink(ctx, f); });
+        }
+        return used;
+    }
+
+    bool send(uint8_t id, const void *payload, uint16_t len) override { return proto_.send(id, payload, len); }
+    bool canQueue(uint16_t len) const override { return proto_.canQueue(len); }
+    void service() override { proto_.poll(); }
+    ProtocolStats stats() const override { return proto_.stats(); }
+
+    /** Sleep until the port has bytes. @return false on timeout */
+    bool waitRx(uint32_t timeoutMs) { return port_.waitRx(timeoutMs); }
+
+    /** The parser underneath, for setResync() / setTimeout() */
+    Parser &parser() { return proto_; }
+
+private:
+    UartPort &port_;
+    Parser proto_;
+};
+
+/* Adapter for an SPISlaveProtocol (the protocol object stays owned by the caller) */
+template <typename Spi>
+class SpiLink : public MuxLink<Spi::Frame::kMaxPayload> {
+public:
+    using Frame = typename Spi::Frame;
+    using Sink = typename MuxLink<Spi::Frame::kMaxPayload>::Sink;
+
+    explicit SpiLink(Spi &spi) : spi_(spi) {}
+
+    /* A transaction is the unit here, the budget doesn't apply (one poll = at most 2 transactions) */
+    std::size_t pump(std::size_t, Sink sink, void *ctx) override {
+        const uint32_t before = spi_.stats().bytesIn;
+        spi_.poll([&](const Frame &f) { sink(ctx, f); });
+        return spi_.stats().bytesIn - before;
+    }
+
+    bool send(uint8_t id, const void *payload, uint16_t len) override { return spi_.send(id, payload, len); }
+    bool canQueue(uint16_t len) const override { return spi_.canQueue(len); }
+    ProtocolStats stats() const override { return spi_.stats(); }
+
+private:
+    Spi &spi_;
+};
+
+template <std::size_t MaxPayload, std::size_t MaxLinks = 2>
+class TransportMux {
+public:
+    using Frame = ProtocolFrame<MaxPayload>;
+    using Link = MuxLink<MaxPayload>;
+    using ClockFn = unsigned long (*)();
+
+    /** Register a link, the order of add() is the order of preference. @return false if MaxLinks is reached */
+    bool add(Link &link) {
+        if (count_ == MaxLinks) return false;
+        const uint32_t now = static_cast<uint32_t>(clock_());
+        links_[count_] = {&link, link.stats(), now, 0, 0, now};
+        ++count_;
+        publishStats();
+        return true;
+    }
+
+    /** @param quietMs: a link with no valid frame for this long is dead. @param clock: ms clock, injectable for tests */
+    void setQuietTimeout(uint32_t quietMs, ClockFn clock = millis) {
+        quietMs_ = quietMs;
+        clock_ = clock;
+    }
+
+    /** @param marginPermille: fail over when the active link's error rate is this much (per mille) above another alive
+     * link's. @param halfLifeMs: how fast old errors are forgotten */
+    void setErrorFailover(uint16_t marginPermille, uint32_t halfLifeMs = 1000) {
+        marginPermille_ = marginPermille;
+        halfLifeMs_ = halfLifeMs ? halfLifeMs : 1;
+    }
+
+    /** @param bytes: max bytes pulled from each link per receive() */
+    void setBudget(std::size_t bytes) { budget_ = bytes; }
+
+    /** Drain every link (fairly), hand every valid frame to onFrame(const Frame&), then re-evaluate the active link.
+     * @return number of frames received */
+    template <typename OnFrame>
+    std::size_t receive(OnFrame &&onFrame) {
+        struct Ctx {
+            typename std::remove_reference<OnFrame>::type *fn;
+            std::size_t frames;
+        } ctx{&onFrame, 0};
+        auto sink = [](void *c, const Frame &f) {
+            Ctx *x = static_cast<Ctx*>(c);
+            (*x->fn)(f);
+            ++x->frames;
+        };
+
+        for (uint8_t i = 0; i < count_; ++i) {
+            links_[(first_ + i) % count_].link->pump(budget_, sink, &ctx);
+        }
+        if (count_ > 0) first_ = static_cast<uint8_t>((first_ + 1) % count_);   // rotate who goes first
+
+        updateHealth();
+        return ctx.frames;
+    }
+
+    /** Send on the active link. @return false if there is no link or it dropped the frame */
+    bool send(uint8_t id, const void *payload, uint16_t len) {
+        if (count_ == 0) return false;
+        return links_[active_.load(std::memory_order_acquire)].link->send(id, payload, len);
+    }
+
+    /** Would the active link take a frame of len payload bytes right now? */
+    bool canQueue(uint16_t len) const {
+        if (count_ == 0) return false;
+        return links_[active_.load(std::memory_order_acquire)].link->canQueue(len);
+    }
+
+    /** Same as SerialProtocol::send(const SuperframeBuilder&) but on the active link */
+    template <std::size_t Capacity>
+    bool send(const SuperframeBuilder<Capacity> &sf) {
+        static_assert(Capacity <= MaxPayload, "superframe bigger than MaxPayload");
+        if (sf.empty()) return true;
+        if (sf.count() == 1) return send(sf.data()[0], sf.data() + kRecordOverhead, sf.data()[1]);
+        return send(kSuperframeId, sf.data(), sf.size());
+    }
+
+    /** Let every link push its pending TX bytes */
+    void service() {
+        for (uint8_t i = 0; i < count_; ++i) links_[i].link->service();
+    }
+
+    /** Index (add order) of the link TX currently goes to */
+    uint8_t active() const { return active_.load(std::memory_order_relaxed); }
+
+    /** How many times TX moved to another link */
+    uint32_t failovers() const { return failovers_.load(std::memory_order_relaxed); }
+
+    /** Recent error rate of a link (per mille, see setErrorFailover()). RX side only */
+    uint16_t errorRate(uint8_t link) const { return link < count_ ? rate(links_[link]) : 0; }
+
+    /** Sum of the counters of every link, as of the last receive(). Safe from any task, whatever its priority: it is
+     * always one receive()'s snapshot, never half of two. The TX counters in it were read by receive() while the TX
+     * task may have been bumping them (relaxed atomics in the links), so at worst it misses the last frame */
+    ProtocolStats stats() const {
+        uint32_t words[kStatsWords];
+        uint32_t gen;
+        do {
+            gen = statsGen_.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < kStatsWords; ++i) words[i] = stats_[gen & 1u][i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (statsGen_.load(std::memory_order_relaxed) != gen);     // receive() published again meanwhile
+        ProtocolStats sum;
+        std::memcpy(&sum, words, sizeof(sum));
+        return sum;
+    }
+
+private:
+    struct Entry {
+        Link *link;
+        ProtocolStats last;   // counters at the previous receive()
+        uint32_t lastRxMs;    // last time a valid frame came in
+        uint32_t okAvg;       // valid frames, decaying, x256
+        uint32_t errAvg;      // errors, decaying, x256
+        uint32_t decayMs;     // last time both were halved
+    };
+
+    static constexpr uint32_t kMinEvents = 8;     // less recent traffic than that: the rate doesn't count yet
+    static constexpr std::size_t kStatsWords = sizeof(ProtocolStats) / sizeof(uint32_t);
+    static_assert(sizeof(ProtocolStats) == kStatsWords * sizeof(uint32_t), "ProtocolStats must be all uint32_t");
+
+    Entry links_[MaxLinks]{};
+    uint8_t count_ = 0;
+    std::atomic<uint8_t> active_{0};   // written by receive(), read by send()
+    uint8_t first_ = 0;
+    std::size_t budget_ = 256;
+    uint32_t quietMs_ = 500;
+    ClockFn clock_ = millis;
+    std::atomic<uint32_t> failovers_{0};
+    uint16_t marginPermille_ = 50;
+    uint32_t halfLifeMs_ = 1000;
+    std::atomic<uint32_t> statsGen_{0};               // stats_[statsGen_ & 1] is the current snapshot
+    std::atomic<uint32_t> stats_[2][kStatsWords]{};   // sum of every link, receive() fills the other one and flips
+
+    bool alive(const Entry &e, uint32_t now) const { return now - e.lastRxMs <= quietMs_; }
+
+    static uint16_t rate(const Entry &e) {
+        const uint32_t total = e.okAvg + e.errAvg;
+        if (total < (kMinEvents << 8)) return 0;
+        return static_cast<uint16_t>(static_cast<uint64_t>(e.errAvg) * 1000u / total);
+    }
+
+    void publishStats() {
+        ProtocolStats sum;
+        for (uint8_t i = 0; i < count_; ++i) {
+            const ProtocolStats &s = links_[i].last;
+            sum.bytesIn += s.bytesIn;
+            sum.framesOk += s.framesOk;
+            sum.crcFailures += s.crcFailures;
+            sum.lengthRejects += s.lengthRejects;
+            sum.timeouts += s.timeouts;
+            sum.resyncs += s.resyncs;
+            sum.txBytes += s.txBytes;
+            sum.txOverflows += s.txOverflows;
+            sum.creditStalls += s.creditStalls;
+        }
+        uint32_t words[kStatsWords];
+        std::memcpy(words, &sum, sizeof(sum));
+        const uint32_t gen = statsGen_.load(std::memory_order_relaxed) + 1;
+        for (std::size_t i = 0; i < kStatsWords; ++i) stats_[gen & 1u][i].store(words[i], std::memory_order_relaxed);
+        statsGen_.store(gen, std::memory_order_release);
+    }
+
+    void updateHealth() {
+        const uint32_t now = static_cast<uint32_t>(clock_());
+        for (uint8_t i = 0; i < count_; ++i) {
+            Entry &e = links_[i];
+            const ProtocolStats s = e.link->stats();
+            if (s.framesOk != e.last.framesOk) e.lastRxMs = now;
+            const uint32_t errors = (s.crcFailures - e.last.crcFailures) + (s.lengthRejects - e.last.lengthRejects) +
+                                    (s.timeouts - e.last.timeouts);
+            e.okAvg += (s.framesOk - e.last.framesOk) << 8;
+            e.errAvg += errors << 8;
+            uint32_t halvings = (now - e.decayMs) / halfLifeMs_;
+            e.decayMs += halvings * halfLifeMs_;
+            if (halvings > 31) halvings = 31;
+            e.okAvg >>= halvings;
+            e.errAvg >>= halvings;
+            e.last = s;
+        }
+        publishStats();
+
+        /* Most preferred link that is alive and clearly better than the active one, or not worse if preferred */
+        const uint8_t active = active_.load(std::memory_order_relaxed);
+        const bool activeAlive = alive(links_[active], now);
+        const uint16_t activeRate = rate(links_[active]);
+        for (uint8_t i = 0; i < count_; ++i) {
+            if (i == active || !alive(links_[i], now)) continue;
+            const uint16_t r = rate(links_[i]);
+            const bool better = !activeAlive || activeRate > r + marginPermille_ || (i < active && r <= activeRate);
+            if (better) {
+                active_.store(i, std::memory_order_release);
+                failovers_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+};
+
+#endif /* TRANSPORT_MUX_HPP */
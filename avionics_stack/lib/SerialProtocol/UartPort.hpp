@@ -0,0 +1,201 @@
+/**
+ * @file UartPort.hpp
+ * @author Eliot Abramo
+ * @brief Event-driven UART: a Stream the RX task can block on (waitRx) instead of polling available().
+ * @date 2025-07-03
+ */
+#ifndef UART_PORT_HPP
+#define UART_PORT_HPP
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Same Stream as HardwareSerial for the TX side (SerialProtocol writes into it), plus what the RX side needs:
+ *   waitRx()        -> sleep until bytes are there (or timeout), no CPU burnt on an idle link
+ *   readAvailable() -> bulk, non-blocking read of what's there
+ *
+ * Implementations: the ESP-IDF UART driver below, and a pseudo-terminal on a PC (the other end of the PTY plays the
+ * Raspberry Pi, real bytes, real syscalls, real wake-ups).
+ */
+class UartPort : public Stream {
+public:
+    /** Block until at least one byte can be read. @return false on timeout */
+    virtual bool waitRx(uint32_t timeoutMs) = 0;
+
+    /** Read up to max bytes that are already there, never waits. @return bytes read */
+    virtual std::size_t readAvailable(uint8_t *buf, std::size_t max) = 0;
+
+    /** Times the RX buffer overflowed (nobody read fast enough). Events, not bytes: the driver doesn't say how many
+     * bytes the hardware dropped, and each event also flushes whatever was still buffered */
+    virtual uint32_t rxOverflows() const = 0;
+
+    int peek() override { return -1; }    // SerialProtocol never peeks
+    using Print::write;
+};
+
+#ifdef ESP_PLATFORM
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/**
+ * Owns the UART port through the IDF driver (do NOT Serial.begin() the same port, the driver can only be installed
+ * once). The driver posts a UART_DATA event when either:
+ *   - rxFullThreshold bytes are in the hardware FIFO (burst), or
+ *   - the line has been idle for rxTimeoutSymbols byte times after the last byte (end of a frame).
+ *
+ * Why not the IDF pattern detection on 0xA5 0x5A: the AT_CMD pattern interrupt only matches N times the SAME
+ * character (made for "+++"), it can't match two different bytes. The idle timeout gives the same "frame is done,
+ * wake up" without it, and the STX hunt stays in the parser where it already is.
+ *
+ * TX: no driver TX ring, uart_write_bytes() goes straight to the 128 B hardware FIFO. availableForWrite() only says
+ * yes when the FIFO is completely drained, so SerialProtocol::poll() (buffered TX) never blocks.
+ */
+class Esp32UartPort : public UartPort {
+public:
+    Esp32UartPort(uart_port_t port, uint32_t baud, int txPin = UART_PIN_NO_CHANGE, int rxPin = UART_PIN_NO_CHANGE,
+                  uint8_t rxFullThreshold = 64, uint8_t rxTimeoutSymbols = 2, int rxBufSize = 1024)
+        : port_(port), baud_(baud), txPin_(txPin), rxPin_(rxPin), rxFull_(rxFullThreshold),
+          rxTimeout_(rxTimeoutSymbols), rxBufSize_(rxBufSize) {}
+
+    bool begin() {
+        uart_config_t cfg = {};
+        cfg.baud_rate = static_cast<int>(baud_);
+        cfg.data_bits = UART_DATA_8_BITS;
+        cfg.parity = UART_PARITY_DISABLE;
+        cfg.stop_bits = UART_STOP_BITS_1;
+        cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+        if (uart_driver_install(port_, rxBufSize_, 0, kEventDepth, &events_, 0) != ESP_OK) return false;
+        if (uart_param_config(port_, &cfg) != ESP_OK) return false;
+        if (uart_set_pin(port_, txPin_, rxPin_, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) return false;
+        if (uart_set_rx_full_threshold(port_, rxFull_) != ESP_OK) return false;
+        return uart_set_rx_timeout(port_, rxTimeout_) == ESP_OK;
+    }
+
+    /* Every queued event is taken, even when bytes are already there (no wait then): left in the queue, the UART_DATA
+     * events of bytes read long ago would wake the next waitRx() for nothing, and an overflow would go unnoticed */
+    bool waitRx(uint32_t timeoutMs) override {
+        uart_event_t e;
+        const TickType_t wait = available() > 0 ? 0 : pdMS_TO_TICKS(timeoutMs);
+        if (xQueueReceive(events_, &e, wait) == pdTRUE) {
+            do {
+                if (e.type == UART_FIFO_OVF || e.type == UART_BUFFER_FULL) {
+                    /* What's in there is already broken, start clean, the parser resyncs on the next STX */
+                    ++overflows_;
+                    uart_flush_input(port_);
+                    xQueueReset(events_);
+                    return false;
+                }
+            } while (xQueueReceive(events_, &e, 0) == pdTRUE);
+        }
+        return available() > 0;
+    }
+
+    std::size_t readAvailable(uint8_t *buf, std::size_t max) override {
+        const int n = uart_read_bytes(port_, buf, static_cast<uint32_t>(max), 0);
+        return n > 0 ? static_cast<std::size_t>(n) : 0;
+    }
+
+    uint32_t rxOverflows() const override { return overflows_; }
+
+    int available() override {
+        std::size_t n = 0;
+        uart_get_buffered_data_len(port_, &n);
+        return static_cast<int>(n);
+    }
+    int read() override {
+        uint8_t b;
+        return uart_read_bytes(port_, &b, 1, 0) == 1 ? b : -1;
+    }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *data, size_t len) override {
+        const int n = uart_write_bytes(port_, reinterpret_cast<const char*>(data), len);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    int availableForWrite() override { return uart_wait_tx_done(port_, 0) == ESP_OK ? kTxFifo : 0; }
+    void flush() override { uart_wait_tx_done(port_, portMAX_DELAY); }
+
+private:
+    static constexpr int kEventDepth = 16;
+    static constexpr int kTxFifo = 128;
+
+    uart_port_t port_;
+    uint32_t baud_;
+    int txPin_, rxPin_;
+    uint8_t rxFull_, rxTimeout_;
+    int rxBufSize_;
+    QueueHandle_t events_ = nullptr;
+    uint32_t overflows_ = 0;    // overflow events, see rxOverflows()
+};
+
+#elif defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * Host stand-in: the master side of a pseudo-terminal. Open slaveName() from the test (or from a real tool, it's a
+ * tty) and write frames into it, waitRx() sleeps in poll() exactly like the ESP sleeps on the event queue.
+ */
+class PtyUartPort : public UartPort {
+public:
+    ~PtyUartPort() override {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    bool begin() {
+        fd_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd_ < 0 || ::grantpt(fd_) != 0 || ::unlockpt(fd_) != 0) return false;
+        termios t;
+        if (::tcgetattr(fd_, &t) == 0) {
+            ::cfmakeraw(&t);
+            ::tcsetattr(fd_, TCSANOW, &t);
+        }
+        return ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK) == 0;
+    }
+
+    /** Path of the other end (/dev/pts/N) */
+    const char *slaveName() const { return fd_ >= 0 ? ::ptsname(fd_) : nullptr; }
+
+    bool waitRx(uint32_t timeoutMs) override {
+        pollfd p = {fd_, POLLIN, 0};
+        return ::poll(&p, 1, static_cast<int>(timeoutMs)) > 0 && (p.revents & POLLIN);
+    }
+
+    std::size_t readAvailable(uint8_t *buf, std::size_t max) override {
+        const ssize_t n = ::read(fd_, buf, max);
+        return n > 0 ? static_cast<std::size_t>(n) : 0;
+    }
+
+    uint32_t rxOverflows() const override { return 0; }    // the kernel buffers, nothing is dropped here
+
+    int available() override {
+        int n = 0;
+        return ::ioctl(fd_, FIONREAD, &n) == 0 ? n : 0;
+    }
+    int read() override {
+        uint8_t b;
+        return readAvailable(&b, 1) == 1 ? b : -1;
+    }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *data, size_t len) override {
+        const ssize_t n = ::write(fd_, data, len);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    int availableForWrite() override { return 4096; }
+
+private:
+    int fd_ = -1;
+};
+#endif
+
+#endif /* UART_PORT_HPP */
@@ -11,6 +11,8 @@
 #include "Nexus.hpp"
 #include "Servo.hpp"
 #include "Dust_Driver.hpp"
+#include "TelemetryScheduler.hpp"
+#include "Rtos.hpp"
 
 /**
  * servo id 1 = cam front
@@ -104,123 +106,221 @@ void tareScales() {
 }
 /*******************************************************************************************/
 
+/******************************* Tasks  ****************************************************/
+/**
+ * Three tasks instead of one loop(), so a tare (100 ms), an I2C read or a slow UART never holds up the others:
+ *
+ *   RX task     (core 0, prio 3): Nexus::receive(), owns the servos
+ *   TX task     (core 0, prio 2): telemetry scheduler + Nexus::poll(), the only one that sends
+ *   sensor task (core 1, prio 2): owns the HX711s and the dust sensor, handles the tare requests
+ *
+ * They only talk through the static queues below (and Nexus' Change queue, RX -> sensor).
+ * Nobody touches another task's hardware.
+ */
+struct MassSample {
+  float drill;
+  float hd;
+};
 
-void setup() {
-  // lower CPU clock to 80 MHz (saves power, reduces noise)
-  rtc_cpu_freq_config_t cfg;
-  rtc_clk_cpu_freq_get_config(&cfg);
-  rtc_clk_cpu_freq_to_config(RTC_CPU_FREQ_80M, &cfg);
-  rtc_clk_cpu_freq_set_config_fast(&cfg);
+static rtos::Queue<MassSample, 4> massSamples;    // sensor -> TX, latest weights
+static rtos::Queue<DustData, 2> dustSamples;      // sensor -> TX
+static rtos::Queue<MassPacket, 4> massReplies;    // sensor -> TX, tare acknowledgements
+static rtos::Queue<ServoRequest, 4> localServo;   // TX -> RX, servo moves decided on board
 
-  Serial.begin(115200);
+static rtos::Task<4096> rxTask;
+static rtos::Task<4096> txTask;
+static rtos::Task<4096> sensorTask;
 
-  // Mass
-  mass_drill.tare();  
-  offset_drill = mass_drill.read();
+/******************************* Telemetry  ************************************************/
+/**
+ * Everything the ESP sends on its own goes through the scheduler, one function per stream.
+ * Phases are spread over the second so the streams never leave in the same tick.
+ * Runs in the TX task, on the latest samples the sensor task handed over.
+ */
+static MassSample lastMass = {0.0f, 0.0f};
+static DustData lastDust;
+static bool haveDust = false;
+
+void sendMass() {
+  MassPacket drill = {
+    MassDrill_ID,
+    lastMass.drill
+  };
+  nexus.send(drill);
+
+  MassPacket hd = {
+    MassHD_ID,
+    lastMass.hd
+  };
+  nexus.send(hd);
+
+  // If mass above 200g for the drill, then we just put the Servo back under rover.
+  if(lastMass.drill >= 200){
+    ServoRequest request = {
+      ServoDrill_ID,
+      -1000,
+      false
+    };
+    localServo.send(request);    // the RX task owns the servos
+  }
+  // Serial.printf("Drill: %.2f g | HD: %.2f g\n", drill.mass, hd.mass);
+}
 
-  mass_hd.tare();  
-  offset_hd = mass_hd.read();
+void sendDust() {
+  if(haveDust){
+    nexus.send(lastDust);
+    haveDust = false;
+  }
+}
 
-  // Servo
-  servo_cam->init(SERVO_CAM_PIN, SERVO_CAM_CHAN);
-  servo_drill->init(SERVO_DRILL_PIN, SERVO_DRILL_CHAN);
+void sendHeartbeat() { nexus.sendHeartbeat(); }
+void sendLinkStats() { nexus.sendLinkStats(); }
+
+/* Everything on the same phase and all of it allowed in one tick: whatever is due together is sent during the
+ * same loop() and leaves as ONE superframe (NEXUS_BATCH_TELEMETRY), ~95 bytes every second plus a lone heartbeat
+ * in between. Spreading them over different phases would cost one frame envelope per stream instead. */
+static const TelemetryStream telemetry[] = {
+  // name         period (ms)            phase (ms)  priority  fn
+  {"heartbeat",   500,                   0,          0,        sendHeartbeat},
+  {"mass",        1000,                  0,          1,        sendMass},
+  {"dust",        1000,                  0,          2,        sendDust},
+  {"link_stats",  LINK_STATS_PERIOD_MS,  0,          3,        sendLinkStats},
+};
+static constexpr uint8_t kTelemetryStreams = sizeof(telemetry) / sizeof(telemetry[0]);
+static TelemetryScheduler<kTelemetryStreams> scheduler(telemetry, kTelemetryStreams);
+/*******************************************************************************************/
 
-  // Dust
-  dust->init();
+void rxLoop(void *) {
+  while (rtos::running()) {
+    nexus.waitForData(10);     // sleeps while the link is idle, wakes up as soon as a frame is in
+    nexus.receive(servo_cam, servo_drill);
+
+    ServoRequest request;
+    while (localServo.receive(request)) {
+      servo_drill->set_request(request);
+      servo_drill->handle_servo();
+    }
+  }
 }
 
-void loop() {
-  /**
-   * Receive command from Nexus and determine if change is needed 
-   * Change is only for the Mass. Part of the things THAT YOU NEED TO CHANGE PLEASE.
-   * This just allows for a very very simple fsm and direct access.
-   * Time was the issue here, so please take the time to think of something better :)
-   */
-  Change changeMass = nexus.receive(servo_cam, servo_drill);
-
-  switch (changeMass.id) {
-
-    case MassDrill_Request_ID:
-    {
-      offset_drill = mass_drill.read();
-      mass_drill.tare();
-      for (uint8_t i = 0; i < AVG_SIZE; ++i) {
-          drillBuf[i] = offset_drill;
-      }
+void txLoop(void *) {
+  scheduler.start();
+  while (rtos::running()) {
+    MassSample sample;
+    while (massSamples.receive(sample)) lastMass = sample;
+    DustData dust_packet;
+    while (dustSamples.receive(dust_packet)) {
+      lastDust = dust_packet;
+      haveDust = true;
+    }
 
-      MassPacket drill_change = {
-        MassDrill_ID,
-        weight_drill
-      };
+    MassPacket reply;
+    while (massReplies.receive(reply)) nexus.send(reply);
 
-      nexus.sendMassPacket(&drill_change, MassDrill_ID);
-      delay(100);
-      break;
-    }
+    scheduler.tick();
+    nexus.poll();
+    rtos::delayMs(1);
+  }
+}
 
-    case MassHD_Request_ID:
-    {
-      offset_hd    = mass_hd.read();
-      mass_hd.tare();
-      for (uint8_t i = 0; i < AVG_SIZE; ++i) {
-          hdBuf[i]    = offset_hd;
+void sensorLoop(void *) {
+  uint32_t last_dust = rtos::nowMs();
+  while (rtos::running()) {
+    /**
+     * Change is only for the Mass. Part of the things THAT YOU NEED TO CHANGE PLEASE.
+     * This just allows for a very very simple fsm and direct access.
+     */
+    Change changeMass;
+    while (nexus.nextChange(changeMass)) {
+      switch (changeMass.id) {
+
+        case MassDrill_Request_ID:
+        {
+          offset_drill = mass_drill.read();
+          mass_drill.tare();
+          for (uint8_t i = 0; i < AVG_SIZE; ++i) {
+              drillBuf[i] = offset_drill;
+          }
+
+          MassPacket drill_change = {
+            MassDrill_ID,
+            weight_drill
+          };
+
+          massReplies.send(drill_change);
+          rtos::delayMs(100);
+          break;
+        }
+
+        case MassHD_Request_ID:
+        {
+          offset_hd    = mass_hd.read();
+          mass_hd.tare();
+          for (uint8_t i = 0; i < AVG_SIZE; ++i) {
+              hdBuf[i]    = offset_hd;
+          }
+          rtos::delayMs(100);
+
+          MassPacket hd_change = {
+            MassHD_ID,
+            weight_drill
+          };
+
+          massReplies.send(hd_change);
+
+          break;
+        }
       }
-      delay(100);
-
-      MassPacket hd_change = {
-        MassHD_ID,
-        weight_drill
-      };
+    }
 
-      nexus.sendMassPacket(&hd_change, MassDrill_ID);
+    updateDrill();
+    updateHD();
+    massSamples.send({weight_drill, weight_hd});
 
-      break;
+    if (rtos::nowMs() - last_dust >= 1000) {
+      last_dust = rtos::nowMs();
+      if(dust->is_alive()){
+        DustData dust_packet;
+        dust->loop(&dust_packet);
+        dustSamples.send(dust_packet);
+      }
     }
+    rtos::delayMs(5);    // HX711 converts every 12.5 ms
   }
+}
 
-  updateDrill();
-  updateHD();
 
-  static uint32_t lastMass = 0;    // ms
-  static uint32_t last_send_dust = 0;
+void setup() {
+  // lower CPU clock to 80 MHz (saves power, reduces noise)
+  rtc_cpu_freq_config_t cfg;
+  rtc_clk_cpu_freq_get_config(&cfg);
+  rtc_clk_cpu_freq_to_config(RTC_CPU_FREQ_80M, &cfg);
+  rtc_clk_cpu_freq_set_config_fast(&cfg);
 
-  if (millis() - lastMass >= 1000) {
-    lastMass = millis();
-    MassPacket drill = {
-      MassDrill_ID,
-      weight_drill
-    };
-    nexus.sendMassPacket(&drill, MassDrill_ID);
+  // UART0 is opened by Nexus (see NEXUS_UART_EVENTS), don't Serial.begin() it here
+  nexus.begin();
 
-    MassPacket hd = {
-      MassHD_ID,
-      weight_hd
-    };
-    nexus.sendMassPacket(&hd, MassHD_ID);
-
-    // If mass above 200g for the drill, then we just put the Servo back under rover.
-    if(weight_drill >= 200){
-      ServoRequest request = {
-        ServoDrill_ID,
-        -1000,
-        false
-      };
-      servo_drill->set_request(request);
-      servo_drill->handle_servo();   
-    }
-    // Serial.printf("Drill: %.2f g | HD: %.2f g\n", drill.mass, hd.mass);
-  }
+  // Mass
+  mass_drill.tare();  
+  offset_drill = mass_drill.read();
 
-  if (millis() - last_send_dust >= 1000) {
-    last_send_dust = millis();
-    if(dust->is_alive()){
-      DustData dust_packet;
-      dust->loop(&dust_packet);
-      nexus.sendDustDataPacket(&dust_packet);
-    }
-  }
+  mass_hd.tare();  
+  offset_hd = mass_hd.read();
 
-  nexus.sendHeartbeat();
+  // Servo
+  servo_cam->init(SERVO_CAM_PIN, SERVO_CAM_CHAN);
+  servo_drill->init(SERVO_DRILL_PIN, SERVO_DRILL_CHAN);
+
+  // Dust
+  dust->init();
 
+  // Tasks                   name      fn          arg      prio  core
+  rxTask.start(              "rx",     rxLoop,     nullptr, 3,    0);
+  txTask.start(              "tx",     txLoop,     nullptr, 2,    0);
+  sensorTask.start(          "sensor", sensorLoop, nullptr, 2,    1);
 }
 
+void loop() {
+  // Everything runs in the tasks above
+  rtos::delayMs(1000);
+}
@@ -0,0 +1,151 @@
+/* buffered_tx.cpp  ----------------------------------------------------------
+ * SerialProtocol's buffered TX (3rd template argument, TxBufSize):
+ *
+ *   overflow   frames queued past the ring's capacity on a stalled Stream:
+ *              the NEW frame is dropped whole and counted in txOverflows,
+ *              what was queued before stays
+ *   drain      poll() hands out no more than availableForWrite(), and the
+ *              bytes come out in send() order, frame by frame, parseable
+ *   timing     one telemetry burst of Nexus (2x MassPacket, DustData,
+ *              Heartbeat) on a 115200 baud UART with a 128 B FIFO, send()
+ *              time synchronous (flush() waits for the FIFO) vs buffered:
+ *              what loop() pays per burst
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <SerialProtocol.hpp>
+#include <packet_definition.hpp>
+
+// A UART in real time: 11520 B/s leave a 128 B FIFO, write() waits for room like HardwareSerial, flush() waits
+// for the FIFO to empty
+class SlowUart : public Stream
+{
+public:
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t*, size_t n) override
+    {
+        for (size_t i = 0; i < n; ++i) {
+            while (fifo() >= kFifo) {}
+            ++written_;
+        }
+        return n;
+    }
+    using Print::write;
+    int availableForWrite() override { return static_cast<int>(kFifo - fifo()); }
+    void flush() override { while (fifo() > 0) {} }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    static constexpr size_t kFifo = 128;
+    Stopwatch clock_;
+    size_t written_ = 0;
+
+    size_t fifo()
+    {
+        const size_t gone = static_cast<size_t>(clock_.seconds() * 11520);
+        return written_ > gone ? written_ - gone : 0;
+    }
+};
+
+// A FIFO of `room` bytes nobody empties: every byte written takes one
+struct StalledUart : MemStream {
+    size_t write(uint8_t b) override
+    {
+        --room;
+        return MemStream::write(b);
+    }
+    using Print::write;
+};
+
+static std::vector<int> ids(const std::vector<uint8_t>& wire)
+{
+    MemStream s;
+    SerialProtocol<64> rx(s);
+    std::vector<int> out;
+    rx.processBytes(wire.data(), wire.size(), [&](const auto& f) { out.push_back(f.id); });
+    return out;
+}
+
+static void overflowAndDrain()
+{
+    StalledUart s;
+    SerialProtocol<64, Crc16Table, 128> tx(s);
+    const uint8_t p[30] = {};
+    s.room = 0;                                         // UART stalled
+    for (uint8_t id = 1; id <= 3; ++id) CHECK(tx.send(id, p, 24));      // 3 x 31 B
+    CHECK(tx.txPending() == 93);
+    CHECK(!tx.canQueue(30));
+    CHECK(!tx.send(4, p, 30));                          // 37 B, 35 left: the new one goes, never a partial frame
+    CHECK(tx.canQueue(20) && tx.send(5, p, 20));        // 27 B still fit
+    CHECK(tx.stats().txOverflows == 1);
+    CHECK(tx.txPending() == 120 && s.tx.empty());
+
+    s.room = 10;
+    CHECK(tx.poll() == 10 && tx.poll() == 0);           // never more than availableForWrite()
+    CHECK(s.tx.size() == 10 && tx.txPending() == 110);
+    s.room = 1 << 30;
+    CHECK(tx.poll() == 110 && tx.txPending() == 0);
+    CHECK(tx.stats().txBytes == 120);
+    CHECK((ids(s.tx) == std::vector<int>{1, 2, 3, 5}));
+
+    CHECK(tx.send(6, p, 30));                           // the ring is usable again, and send() polls by itself
+    CHECK(tx.txPending() == 0 && ids(s.tx).back() == 6);
+}
+
+template<typename Proto>
+static void burst(Proto& proto)
+{
+    const MassPacket drill{5, 1.5f}, hd{6, 2.5f};
+    const DustData dust{};
+    const Heartbeat hb{};
+    proto.send(5, &drill, sizeof drill);
+    proto.send(6, &hd, sizeof hd);
+    proto.send(15, &dust, sizeof dust);
+    proto.send(2, &hb, sizeof hb);
+}
+
+static void timing()
+{
+    constexpr int kBursts = 20;
+    double syncUs = 0, bufUs = 0, pollUs = 0;
+    long polls = 0;
+    {
+        SlowUart uart;
+        SerialProtocol<128> proto(uart);
+        for (int i = 0; i < kBursts; ++i) {
+            Stopwatch sw;
+            burst(proto);
+            syncUs += sw.nanos() / 1e3;
+        }
+    }
+    {
+        SlowUart uart;
+        SerialProtocol<128, Crc16Table, 512> proto(uart);
+        for (int i = 0; i < kBursts; ++i) {
+            Stopwatch sw;
+            burst(proto);
+            bufUs += sw.nanos() / 1e3;
+            Stopwatch idle;                             // rest of a 10 ms loop, polling like loop() does
+            while (idle.seconds() < 0.01) {
+                Stopwatch p;
+                proto.poll();
+                pollUs += p.nanos() / 1e3;
+                ++polls;
+            }
+        }
+        CHECK(proto.stats().txOverflows == 0);
+    }
+    std::printf("telemetry burst (2x mass, dust, heartbeat = %zu B) at 115200 baud: synchronous send() %.1f us, "
+                "buffered send() %.2f us (+ %.3f us per poll() call)\n",
+                4 * SerialProtocol<128>::kFrameOverhead + 2 * sizeof(MassPacket) + sizeof(DustData) + sizeof(Heartbeat),
+                syncUs / kBursts, bufUs / kBursts, pollUs / polls);
+}
+
+int main()
+{
+    overflowAndDrain();
+    timing();
+    return testResult();
+}
@@ -0,0 +1,27 @@
+/* router_duplicate_id.cpp  --------------------------------------------------
+ * Must NOT compile: two PacketRouter routes on the same packet ID.
+ * ctest checks the compiler stops on PacketRouter's own static_assert, and
+ * that the same file with -DCOMPILE_FAIL_CONTROL (IDs 1 and 2) does compile,
+ * so the failure can't come from anything else.
+ * -------------------------------------------------------------------------*/
+#include <PacketRouter.hpp>
+
+struct Ctx {};
+struct Pkt { float a; };
+
+static void onPkt(Ctx &, const Pkt &) {}
+
+#ifdef COMPILE_FAIL_CONTROL
+constexpr uint8_t kSecondId = 2;
+#else
+constexpr uint8_t kSecondId = 1;
+#endif
+
+using Router = PacketRouter<Ctx, 128, Route<1, Pkt, onPkt>, Route<kSecondId, Pkt, onPkt>>;
+
+int main()
+{
+    Ctx c;
+    const uint8_t payload[sizeof(Pkt)] = {};
+    return Router::dispatch(c, 1, payload, sizeof payload) ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+/* send_unregistered.cpp  ----------------------------------------------------
+ * Must NOT compile: Nexus::send<T>() with a type packet_traits.hpp doesn't
+ * know (send() is reproduced here on a plain SerialProtocol, Nexus itself
+ * needs the ESP). With -DCOMPILE_FAIL_CONTROL it sends a DustData instead
+ * and has to compile.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <SerialProtocol.hpp>
+#include <packet_traits.hpp>
+
+struct Unregistered { uint16_t a, b; };
+
+#ifdef COMPILE_FAIL_CONTROL
+using Pkt = DustData;
+#else
+using Pkt = Unregistered;
+#endif
+
+template <typename T>
+void send(SerialProtocol<128> &proto, const T &pkt)
+{
+    proto.send(packetId(pkt), &pkt, sizeof(T));     // Nexus::send() -> publish(packetId(pkt), &pkt, sizeof(T))
+}
+
+int main()
+{
+    MemStream s;
+    SerialProtocol<128> proto(s);
+    send(proto, Pkt{});
+    return 0;
+}
@@ -0,0 +1,165 @@
+/* decoder_corruption.cpp  ---------------------------------------------------
+ * Bad frames on the line, through the parser and through the avionics_debug
+ * decoders (pty, like decoder_pty_bench):
+ *
+ *     decoder_corruption <decoder>...
+ *
+ *   good, bad CRC, good, oversized length, good
+ *
+ * The bad CRC frame has a 0xA5 0x5A inside its payload, the kind of thing
+ * the resync parser rescans and rejects a second time.
+ *
+ * Checks: the parser (resync off and on, processByte and processBytes)
+ * counts 3 ok, 1 bad CRC and 1 bad length: one failure per rejected frame,
+ * not per candidate rescanned inside it. Each decoder prints the 3 good
+ * frames, flags the others as "!! corrupted" with the same counts, and
+ * reports them again when the port closes. Linux only.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include <SerialProtocol.hpp>
+
+static void frame(std::vector<uint8_t>& line, uint8_t id, const uint8_t* p, uint16_t len)
+{
+    MemStream s;
+    SerialProtocol<128> enc(s);
+    enc.send(id, p, len);
+    line.insert(line.end(), s.tx.begin(), s.tx.end());
+}
+
+static std::vector<uint8_t> capture()
+{
+    std::vector<uint8_t> line;
+    const uint8_t good[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    const uint8_t trap[12] = {0xA5, 0x5A, 0x04, 0x00, 0x07, 1, 2, 3, 4, 5, 6, 7};     // a frame header in the payload
+    frame(line, 3, good, sizeof good);
+    frame(line, 15, trap, sizeof trap);
+    line.back() ^= 0xFF;                                                              // bad CRC
+    frame(line, 21, good, sizeof good);
+    const uint8_t oversized[] = {0xA5, 0x5A, 0x00, 0x02, 0x30};                       // 512 B, MaxPayload is 128
+    line.insert(line.end(), std::begin(oversized), std::end(oversized));
+    line.insert(line.end(), 20, 0x11);
+    frame(line, 30, good, 8);
+    return line;
+}
+
+static void parser(const std::vector<uint8_t>& line)
+{
+    for (bool resync : {false, true}) {
+        for (bool bulk : {false, true}) {
+            MemStream s;
+            SerialProtocol<128> rx(s);
+            rx.setResync(resync);
+            if (bulk) {
+                rx.processBytes(line.data(), line.size(), [](const auto&) {});
+            } else {
+                for (uint8_t b : line) rx.processByte(b);
+            }
+            const ProtocolStats st = rx.stats();
+            std::printf("parser resync %-3s %-12s: %u ok, %u bad CRC, %u bad length, %u resyncs\n",
+                        resync ? "on" : "off", bulk ? "processBytes" : "processByte", st.framesOk, st.crcFailures,
+                        st.lengthRejects, st.resyncs);
+            CHECK(st.framesOk == 3 && st.crcFailures == 1 && st.lengthRejects == 1);
+        }
+    }
+}
+
+struct Output { std::string out, err; };
+
+// The capture through a pty into the decoder, then hang up: everything it printed on stdout and stderr
+static Output decode(const char* decoder, const std::vector<uint8_t>& line)
+{
+    Output o;
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    const char* slaveName = ptsname(master);
+    const int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    int out[2], err[2];
+    if (pipe(out) != 0 || pipe(err) != 0) return o;
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(master);
+        close(slave);
+        close(out[0]);
+        close(err[0]);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(err[1], STDERR_FILENO);
+        execl(decoder, decoder, slaveName, "115200", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(out[1]);
+    close(err[1]);
+    close(slave);
+    usleep(300000);
+
+    const ssize_t n = write(master, line.data(), line.size());
+    (void)n;
+    usleep(300000);
+    close(master);                                      // hang up: the decoder prints its totals and exits
+
+    char buf[4096];
+    pollfd p[2] = {{out[0], POLLIN, 0}, {err[0], POLLIN, 0}};
+    for (int open = 2; open > 0 && poll(p, 2, 2000) > 0;) {
+        for (int i = 0; i < 2; ++i) {
+            if (!(p[i].revents & (POLLIN | POLLHUP))) continue;
+            const ssize_t r = read(p[i].fd, buf, sizeof buf);
+            if (r > 0) {
+                (i ? o.err : o.out).append(buf, static_cast<size_t>(r));
+            } else {
+                p[i].fd = -1;
+                --open;
+            }
+        }
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    close(out[0]);
+    close(err[0]);
+    return o;
+}
+
+static void decoders(int argc, char** argv, const std::vector<uint8_t>& line)
+{
+    for (int a = 1; a < argc; ++a) {
+        const Output o = decode(argv[a], line);
+        long frames = 0;
+        unsigned crc = 0, length = 0, markers = 0;
+        for (size_t at = 0; (at = o.out.find("id=0x", at)) != std::string::npos; at += 5) ++frames;
+        for (size_t at = 0; (at = o.out.find("!! corrupted: ", at)) != std::string::npos; ++at) {
+            unsigned c = 0, l = 0;
+            if (std::sscanf(o.out.c_str() + at, "!! corrupted: %u bad CRC, %u bad length", &c, &l) == 2) {
+                crc += c;
+                length += l;
+                ++markers;
+            }
+        }
+        std::printf("%s: %ld frames printed, %u \"!! corrupted\" lines (%u bad CRC, %u bad length), on close: %s",
+                    argv[a], frames, markers, crc, length, o.err.c_str());
+        CHECK(frames == 3);
+        CHECK(markers >= 1 && crc == 1 && length == 1);
+        CHECK(o.err.find("3 frames ok, 1 bad CRC, 1 bad length") != std::string::npos);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const auto line = capture();
+    parser(line);
+    decoders(argc, argv, line);
+    return testResult();
+}
@@ -0,0 +1,160 @@
+/* decoder_pty_bench.cpp  ----------------------------------------------------
+ * Replays a capture into the avionics_debug decoders through a pseudo-
+ * terminal, the way the ESP's USB serial port feeds them:
+ *
+ *     decoder_pty_bench <frames> <decoder>...
+ *
+ * For each decoder: frames/s and CPU time while the capture is pushed as
+ * fast as the pty takes it, CPU burnt during 1 s with nothing on the line,
+ * and what happens when the other end hangs up.
+ *
+ * Checks: every frame comes out as one line, an idle port costs (next to)
+ * no CPU, and the decoder exits by itself after a hang-up.
+ * Linux only (/proc for the child's CPU time).
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include <SerialProtocol.hpp>
+
+// Frames of the sizes the ESP sends, random payloads
+static std::vector<uint8_t> capture(long frames)
+{
+    MemStream s;
+    SerialProtocol<128> enc(s);
+    std::mt19937 rng(1);
+    static const struct { uint8_t id; uint16_t len; } kMix[] = {{3, 12}, {15, 24}, {21, 36}, {30, 8}};
+    uint8_t p[64];
+    for (long i = 0; i < frames; ++i) {
+        for (auto& b : p) b = static_cast<uint8_t>(rng());
+        enc.send(kMix[i % 4].id, p, kMix[i % 4].len);
+    }
+    return s.tx;
+}
+
+// utime + stime of a child, in seconds
+static double cpuOf(pid_t pid)
+{
+    char path[64];
+    std::snprintf(path, sizeof path, "/proc/%d/stat", static_cast<int>(pid));
+    FILE* f = std::fopen(path, "r");
+    long ut = 0, st = 0;
+    if (f) {
+        if (std::fscanf(f, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %ld %ld", &ut, &st) != 2) ut = st = 0;
+        std::fclose(f);
+    }
+    return static_cast<double>(ut + st) / sysconf(_SC_CLK_TCK);
+}
+
+struct Result { long lines; double wall, cpu, idleCpu, exitAfter; };
+
+static Result run(const char* decoder, const std::vector<uint8_t>& cap, long frames)
+{
+    Result r{};
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    const char* slaveName = ptsname(master);
+    const int slave = open(slaveName, O_RDWR | O_NOCTTY);   // raw before the decoder opens it, no echo / line mode
+    termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    int out[2];
+    if (pipe(out) != 0) return r;
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(master);                                      // else the hang-up below never reaches the slave
+        close(slave);
+        close(out[0]);
+        dup2(out[1], STDOUT_FILENO);
+        const int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDERR_FILENO);
+        execl(decoder, decoder, slaveName, "115200", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(out[1]);
+    close(slave);                                           // only the decoder holds the slave side now
+    usleep(300000);
+
+    // Idle: nothing on the line for 1 s
+    const double c0 = cpuOf(pid);
+    usleep(1000000);
+    r.idleCpu = cpuOf(pid) - c0;
+
+    // Replay, as fast as the pty takes it
+    fcntl(master, F_SETFL, O_NONBLOCK);
+    fcntl(out[0], F_SETFL, O_NONBLOCK);
+    size_t off = 0;
+    char buf[1 << 16];
+    const double cpu0 = cpuOf(pid);
+    Stopwatch sw;
+    double lastLine = 0;
+    while (r.lines < frames) {
+        pollfd p[2] = {{master, static_cast<short>(off < cap.size() ? POLLOUT : 0), 0}, {out[0], POLLIN, 0}};
+        poll(p, 2, 1000);
+        if (off < cap.size() && (p[0].revents & POLLOUT)) {
+            const ssize_t n = write(master, cap.data() + off, std::min<size_t>(cap.size() - off, 4096));
+            if (n > 0) off += static_cast<size_t>(n);
+        }
+        if (p[1].revents & POLLIN) {
+            ssize_t n;
+            while ((n = read(out[0], buf, sizeof buf)) > 0) r.lines += std::count(buf, buf + n, '\n');
+            lastLine = sw.seconds();
+        }
+        if (off == cap.size() && sw.seconds() - lastLine > 2) break;     // lost frames never come
+    }
+    r.wall = lastLine;
+    r.cpu = cpuOf(pid) - cpu0;
+
+    // Hang up: the decoder should notice and exit on its own
+    close(master);
+    Stopwatch hup;
+    r.exitAfter = -1;
+    while (hup.seconds() < 2) {
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            r.exitAfter = hup.seconds();
+            break;
+        }
+        usleep(10000);
+    }
+    if (r.exitAfter < 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    close(out[0]);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <frames> <decoder>...\n", argv[0]);
+        return 2;
+    }
+    const long frames = std::atol(argv[1]);
+    const auto cap = capture(frames);
+    std::printf("capture: %ld frames, %zu bytes\n", frames, cap.size());
+    for (int a = 2; a < argc; ++a) {
+        const Result r = run(argv[a], cap, frames);
+        std::printf("%s: %ld/%ld frames in %.2f s = %.0f frames/s, %.2f s CPU (%.1f us/frame) | idle 1 s: %.2f s CPU | "
+                    "exit %.2f s after hang-up\n", argv[a], r.lines, frames, r.wall, r.lines / r.wall, r.cpu,
+                    r.cpu / r.lines * 1e6, r.idleCpu, r.exitAfter);
+        CHECK(r.lines == frames);
+        CHECK(r.idleCpu < 0.1);
+        CHECK(r.exitAfter >= 0);
+    }
+    return testResult();
+}
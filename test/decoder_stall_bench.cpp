@@ -0,0 +1,181 @@
+/* decoder_stall_bench.cpp  --------------------------------------------------
+ * The avionics_debug decoders behind a stalling output:
+ *
+ *     decoder_stall_bench <frames/s> <seconds> <stall ms/s> <decoder>...
+ *
+ *   stall   the capture is replayed through a pty at a fixed frame rate,
+ *           master non-blocking: a frame the pty can't take whole is lost,
+ *           like on a UART without flow control. stdout is not read for
+ *           the first <stall ms> of every second (slow terminal, ssh
+ *           hiccup). Prints frames refused by the pty and frames printed.
+ *   gone    stdout is closed, a few frames come in, then the port goes
+ *           quiet: the decoder must see the EPIPE (not die of SIGPIPE)
+ *           and exit with status 0, not sleep on the port until the next
+ *           byte.
+ *
+ * The loss numbers depend on the box and are only printed. Linux only.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include <SerialProtocol.hpp>
+
+// One frame per entry, the sizes the ESP sends
+static std::vector<std::vector<uint8_t>> capture(long frames)
+{
+    std::mt19937 rng(1);
+    static const struct { uint8_t id; uint16_t len; } kMix[] = {{3, 12}, {15, 24}, {21, 36}, {30, 8}};
+    std::vector<std::vector<uint8_t>> out;
+    uint8_t p[64];
+    for (long i = 0; i < frames; ++i) {
+        MemStream s;
+        SerialProtocol<128> enc(s);
+        for (auto& b : p) b = static_cast<uint8_t>(rng());
+        enc.send(kMix[i % 4].id, p, kMix[i % 4].len);
+        out.push_back(std::move(s.tx));
+    }
+    return out;
+}
+
+// The decoder on a fresh pty (raw), stdout to a pipe, stderr to /dev/null
+struct Child {
+    pid_t pid = -1;
+    int master = -1, out = -1;
+
+    explicit Child(const char* decoder)
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        grantpt(master);
+        unlockpt(master);
+        const char* slaveName = ptsname(master);
+        const int slave = open(slaveName, O_RDWR | O_NOCTTY);
+        termios t;
+        tcgetattr(slave, &t);
+        cfmakeraw(&t);
+        tcsetattr(slave, TCSANOW, &t);
+        int p[2];
+        if (pipe(p) != 0) return;
+        pid = fork();
+        if (pid == 0) {
+            close(master);
+            close(slave);
+            close(p[0]);
+            dup2(p[1], STDOUT_FILENO);
+            const int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDERR_FILENO);
+            execl(decoder, decoder, slaveName, "115200", static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(p[1]);
+        close(slave);
+        out = p[0];
+        fcntl(master, F_SETFL, O_NONBLOCK);
+        fcntl(out, F_SETFL, O_NONBLOCK);
+        usleep(300000);
+    }
+
+    // Seconds until it exited by itself (status = waitpid()'s), -1 = still running after timeout s (then killed)
+    double waitExit(double timeout, int& status)
+    {
+        Stopwatch sw;
+        while (sw.seconds() < timeout) {
+            if (waitpid(pid, &status, WNOHANG) == pid) return sw.seconds();
+            usleep(5000);
+        }
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return -1;
+    }
+
+    ~Child()
+    {
+        if (master >= 0) close(master);
+        if (out >= 0) close(out);
+    }
+};
+
+struct Result { long refused, printed; };
+
+static Result stall(const char* decoder, const std::vector<std::vector<uint8_t>>& cap, double rate, double seconds,
+                    int stallMs)
+{
+    Child c(decoder);
+    Result r{};
+    std::string tail;                      // "id=0x" split over two reads
+    char buf[1 << 16];
+    auto count = [&](const char* b, ssize_t n) {
+        tail.append(b, static_cast<size_t>(n));
+        for (size_t at; (at = tail.find("id=0x")) != std::string::npos; tail.erase(0, at + 5)) ++r.printed;
+        if (tail.size() > 4) tail.erase(0, tail.size() - 4);
+    };
+    const long frames = static_cast<long>(cap.size());
+    long next = 0;
+    Stopwatch sw;
+    while (true) {
+        const double t = sw.seconds();
+        for (const long due = std::min(frames, static_cast<long>(t * rate)); next < due; ++next) {
+            const ssize_t n = write(c.master, cap[next].data(), cap[next].size());
+            r.refused += n != static_cast<ssize_t>(cap[next].size());     // a partial one is line garbage
+        }
+        const bool stalled = static_cast<int>(t * 1000) % 1000 < stallMs && next < frames;
+        if (!stalled) {
+            ssize_t n;
+            while ((n = read(c.out, buf, sizeof buf)) > 0) count(buf, n);
+        }
+        if (next == frames && t > seconds + 2) break;
+        usleep(500);
+    }
+    std::printf("%s: %.0f frames/s for %.0f s, stdout stalled %d ms/s: %ld frames, %ld refused by the pty, "
+                "%ld printed (%.2f %% lost)\n", decoder, rate, seconds, stallMs, frames, r.refused, r.printed,
+                100.0 * (frames - r.printed) / frames);
+    int status;
+    c.waitExit(0, status);
+    return r;
+}
+
+// stdout closed, 10 frames, then nothing: @return seconds until the decoder exited cleanly, -1 = it didn't
+static double outputGone(const char* decoder, const std::vector<std::vector<uint8_t>>& cap)
+{
+    Child c(decoder);
+    close(c.out);
+    c.out = -1;
+    for (int i = 0; i < 10; ++i) {
+        const ssize_t n = write(c.master, cap[i].data(), cap[i].size());
+        (void)n;
+    }
+    int status = 0;
+    const double t = c.waitExit(2, status);
+    if (t < 0) std::printf("%s: stdout closed, port quiet: still running 2 s after the last frame\n", decoder);
+    else if (!WIFEXITED(status)) std::printf("%s: stdout closed: killed by signal %d\n", decoder, WTERMSIG(status));
+    else std::printf("%s: stdout closed, port quiet: exit(%d) %.3f s after the last frame\n", decoder,
+                     WEXITSTATUS(status), t);
+    return t >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? t : -1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5) {
+        std::fprintf(stderr, "usage: %s <frames/s> <seconds> <stall ms/s> <decoder>...\n", argv[0]);
+        return 2;
+    }
+    const double rate = std::atof(argv[1]), seconds = std::atof(argv[2]);
+    const int stallMs = std::atoi(argv[3]);
+    const auto cap = capture(static_cast<long>(rate * seconds));
+    for (int a = 4; a < argc; ++a) {
+        const Result r = stall(argv[a], cap, rate, seconds, stallMs);
+        CHECK(r.printed > 0);
+        CHECK(outputGone(argv[a], cap) >= 0);
+    }
+    return testResult();
+}
@@ -0,0 +1,170 @@
+/* flow_control.cpp  ---------------------------------------------------------
+ * Credit-based flow control (SerialProtocol::setFlowControl()) between a
+ * fast sender and a slow receiver, in 1 ms virtual steps for 10 s:
+ *
+ *   - A offers 4 frames of 32 B per ms, the line carries 1152 B/ms each way
+ *     (not the bottleneck), optional bit errors on both directions
+ *   - B parses everything into an 8 deep FrameQueue and the application pops
+ *     one frame every 2 ms (500 frames/s), B advertises the queue's free slots
+ *
+ * Checks: with flow control nothing is dropped at B's queue, even with bit
+ * errors eating data and credit frames, and B still gets about all it can
+ * consume (minus the keepalive recovery time with errors). Without it most
+ * of what is sent is dropped at B.
+ *
+ * Delayed frames: CreditFlow alone. Frames held up for longer than the
+ * keepalive get written off as lost, then arrive after all: the sender must
+ * keep sending, within the peer's free slots.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <cstring>
+#include <random>
+
+#include <FrameQueue.hpp>
+#include <SerialProtocol.hpp>
+
+using Clock = FakeClock<>;
+
+// One direction of the cable
+struct Line { std::deque<uint8_t> q; };
+
+// One end: writes go onto its outgoing line, reads come from what has arrived
+class End : public Stream
+{
+public:
+    Line *out = nullptr, *in = nullptr;
+    int available() override { return static_cast<int>(in->q.size()); }
+    int read() override
+    {
+        if (in->q.empty()) return -1;
+        const int c = in->q.front();
+        in->q.pop_front();
+        return c;
+    }
+    int peek() override { return -1; }
+    size_t write(uint8_t b) override
+    {
+        out->q.push_back(b);
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override { return 1 << 20; }
+};
+
+struct Result { long sent, delivered, dropped, stalls; };
+
+static Result run(bool flow, double ber)
+{
+    constexpr int kMs = 10000, kConsumeEveryMs = 2, kLineBytesPerMs = 1152;
+    Clock::now() = 0;
+    Line aOut, bOut, aIn, bIn;                  // xOut: written by x, on the wire; xIn: arrived at x
+    End a, b;
+    a.out = &aOut; a.in = &aIn;
+    b.out = &bOut; b.in = &bIn;
+    SerialProtocol<64, Crc16Table, 1024> A(a), B(b);
+    A.setTimeout(0, 0, Clock::read);
+    B.setTimeout(0, 0, Clock::read);
+    if (flow) {
+        A.setFlowControl(true, 2, 20000);
+        B.setFlowControl(true, 2, 20000);
+    }
+    FrameQueue<ProtocolFrame<64>, 8> rxq;
+    std::mt19937 rng(1);
+    std::bernoulli_distribution flip(ber);
+    auto carry = [&](Line& from, Line& to) {
+        for (int n = kLineBytesPerMs; n-- && !from.q.empty();) {
+            uint8_t c = from.q.front();
+            from.q.pop_front();
+            for (int i = 0; i < 8; ++i)
+                if (flip(rng)) c ^= static_cast<uint8_t>(1 << i);
+            to.q.push_back(c);
+        }
+    };
+
+    Result r{};
+    const uint8_t p[32] = {};
+    uint8_t buf[4096];
+    for (int ms = 0; ms < kMs; ++ms, Clock::now() += 1000) {
+        for (int k = 0; k < 4; ++k) r.sent += A.send(1, p, sizeof p);
+        A.poll();
+        B.updateCredit(static_cast<uint16_t>(rxq.capacity() - rxq.size()));
+        B.poll();
+        carry(aOut, bIn);
+        carry(bOut, aIn);
+
+        size_t n = 0;
+        while (b.available() && n < sizeof buf) buf[n++] = static_cast<uint8_t>(b.read());
+        B.processBytes(buf, n, rxq);
+        n = 0;
+        while (a.available() && n < sizeof buf) buf[n++] = static_cast<uint8_t>(a.read());
+        A.processBytes(buf, n, [](const auto&) {});
+
+        ProtocolFrame<64> f;
+        if (ms % kConsumeEveryMs == 0 && rxq.pop(f)) ++r.delivered;
+    }
+    r.dropped = rxq.dropped();
+    r.stalls = A.stats().creditStalls;
+    std::printf("flow control %-3s BER %.0e: sent %6ld, delivered %5ld (%5.1f frames/s), dropped at RX %6ld "
+                "(%5.1f %% of sent), sender stalls %6ld\n", flow ? "on" : "off", ber, r.sent, r.delivered,
+                r.delivered / (kMs / 1000.0), r.dropped, r.sent ? 100.0 * r.dropped / r.sent : 0.0, r.stalls);
+    return r;
+}
+
+// Credit frame payload as the peer would send it
+static void credit(CreditFlow& fc, uint32_t received, uint16_t free, uint32_t nowUs)
+{
+    uint8_t p[kCreditPayload];
+    std::memcpy(p, &received, sizeof received);
+    std::memcpy(p + sizeof received, &free, sizeof free);
+    fc.onCredit(p, sizeof p, nowUs);
+}
+
+// Sends while allowed, at most limit: @return frames sent
+static int drain(CreditFlow& fc, int limit = 1000)
+{
+    int n = 0;
+    for (; n < limit && fc.canSend(); ++n) fc.onSent();
+    return n;
+}
+
+static void delayedFrames()
+{
+    CreditFlow fc;
+    fc.configure(1, 10000);
+    credit(fc, 0, 8, 0);
+    const int first = drain(fc);                // 8 in flight, none of them reaches the peer for a while
+    credit(fc, 0, 8, 10000);
+    credit(fc, 0, 8, 20000);                    // a whole period without news: written off
+    const int afterWriteOff = drain(fc, 3);     // 3 more go out
+    credit(fc, 8, 8, 25000);                    // the first 8 were only late
+    const int afterLate = drain(fc);            // counts can't tell the 3 are in flight: up to a window
+    uint32_t received = 8;
+    int stuck = 0;
+    for (uint32_t t = 30000; t < 200000; t += 5000) {     // the peer catches up, keeps 8 free, sender keeps going
+        received = 11 + static_cast<uint32_t>(afterLate) + static_cast<uint32_t>(t - 30000) / 5000 * 8;
+        credit(fc, received, 8, t);
+        stuck += drain(fc) != 8;
+    }
+    std::printf("delayed frames: %d sent, written off, %d more, the late ones land: %d more, then %d stuck periods\n",
+                first, afterWriteOff, afterLate, stuck);
+    CHECK(first == 8 && afterWriteOff == 3);
+    CHECK(afterLate > 0 && afterLate <= 8);
+    CHECK(stuck == 0);
+}
+
+int main()
+{
+    delayedFrames();
+    for (double ber : {0.0, 1e-4}) {
+        const Result off = run(false, ber);
+        const Result on = run(true, ber);
+        CHECK(off.dropped > off.sent / 2);
+        CHECK(on.dropped == 0);
+        // the consumer takes 5000 in 10 s. With bit errors, frames lost on the wire hold their credit until the
+        // next keepalive (20 ms) gives it back, which costs ~10 %
+        CHECK(on.delivered >= (ber == 0.0 ? 4950 : 4000));
+        CHECK(on.stalls > 0);
+    }
+    return testResult();
+}
@@ -0,0 +1,245 @@
+/* fragmentation.cpp  --------------------------------------------------------
+ * Fragmenter / Reassembler / FragmentStream (Fragmentation.hpp) with
+ * SerialProtocol<128>, so 118 B of data per fragment:
+ *
+ *   sizes            0, 1, 117, 118, 119, 4096, 65536 B: the right number of
+ *                    fragments, reassembled and streamed byte for byte
+ *   dropped fragment one fragment of a message lost: that message is
+ *                    reported incomplete, the next one still comes through
+ *   oversized        a message bigger than the Reassembler's buffer is
+ *                    skipped, not written past the buffer
+ *   orphans          joining mid-message: its fragments are counted as
+ *                    orphans, the next message is received whole
+ *
+ * Then the numbers: CPU cost in memory, and goodput over a 115200 baud line
+ * through the 512 B TX ring Nexus uses.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <cstring>
+#include <random>
+
+#include <Fragmentation.hpp>
+#include <SerialProtocol.hpp>
+
+using Clock = FakeClock<>;
+using Frame = SerialProtocol<128>::Frame;
+
+static uint32_t fnv(const uint8_t* p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    while (n--) h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+// FragmentStream consumer: hashes what it is given
+struct Hasher {
+    uint32_t h = 0, bytes = 0;
+    int ends = 0, complete = 0;
+    bool begin(uint8_t, uint32_t)
+    {
+        h = 2166136261u;
+        bytes = 0;
+        return true;
+    }
+    void data(uint32_t, const uint8_t* p, uint16_t n)
+    {
+        for (uint16_t i = 0; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+        bytes += n;
+    }
+    void end(bool ok)
+    {
+        ++ends;
+        complete += ok;
+    }
+};
+
+// Every frame the Fragmenter produces for these messages, one after the other
+static std::vector<Frame> fragments(std::initializer_list<const std::vector<uint8_t>*> messages)
+{
+    MemStream s;
+    SerialProtocol<128> tx(s);
+    Fragmenter<128> frag;
+    for (const auto* m : messages) {
+        CHECK(frag.begin(1, m->data(), static_cast<uint32_t>(m->size())));
+        frag.pump(tx);
+        CHECK(!frag.busy());
+    }
+    std::vector<Frame> frames;
+    SerialProtocol<128> rx(s);
+    rx.processBytes(s.tx.data(), s.tx.size(), [&](const Frame& f) { frames.push_back(f); });
+    return frames;
+}
+
+static void sizes()
+{
+    std::mt19937 rng(1);
+    std::vector<uint8_t> buf(65536);
+    for (size_t size : {0u, 1u, 117u, 118u, 119u, 4096u, 65536u}) {
+        std::vector<uint8_t> msg(size);
+        for (auto& b : msg) b = static_cast<uint8_t>(rng());
+
+        MemStream s;
+        SerialProtocol<128> tx(s);
+        Fragmenter<128> frag;
+        CHECK(frag.begin(9, msg.data(), static_cast<uint32_t>(size)));
+        CHECK(!frag.begin(9, msg.data(), static_cast<uint32_t>(size)));    // busy until pumped
+        const size_t n = frag.pump(tx);
+        CHECK(!frag.busy());
+        CHECK(n == (size ? (size + 117) / 118 : 1));                       // an empty message is one header
+
+        Reassembler whole(buf.data(), buf.size());
+        FragmentStream stream;
+        Hasher hash;
+        int got = 0;
+        SerialProtocol<128> rx(s);
+        rx.processBytes(s.tx.data(), s.tx.size(), [&](const Frame& f) {
+            stream.onFrame(f.id, f.payload.data(), f.length, hash);
+            whole.onFrame(f.id, f.payload.data(), f.length, [&](uint8_t id, const uint8_t* m, uint32_t len) {
+                got += id == 9 && len == size && std::memcmp(m, msg.data(), size) == 0;
+            });
+        });
+        CHECK(got == 1);
+        CHECK(hash.complete == 1 && hash.ends == 1 && hash.bytes == size && hash.h == fnv(msg.data(), size));
+        if (testFailures()) std::printf("size %zu: %zu fragments\n", size, n);
+    }
+}
+
+// m1 (1000 B, 9 fragments) loses its 4th, m2 (300000 B) doesn't fit the 4096 B buffer, m3 (500 B) is fine
+static void droppedAndOversized()
+{
+    const std::vector<uint8_t> m1(1000, 1), m2(300000, 2), m3(500, 3);
+    const auto frames = fragments({&m1, &m2, &m3});
+    std::vector<uint8_t> buf(4096 + 256, 0xEE);          // the last 256 B are not the Reassembler's
+    Reassembler rx(buf.data(), 4096);
+    int m3Ok = 0, others = 0;
+    for (size_t k = 0; k < frames.size(); ++k) {
+        if (k == 3) continue;
+        rx.onFrame(frames[k].id, frames[k].payload.data(), frames[k].length, [&](uint8_t, const uint8_t* m, uint32_t len) {
+            if (len == 500 && m[0] == 3 && m[499] == 3) ++m3Ok;
+            else ++others;
+        });
+    }
+    CHECK(m3Ok == 1 && others == 0);
+    CHECK(rx.stats().incomplete == 1);      // m1
+    CHECK(rx.stats().skipped == 1);         // m2
+    CHECK(rx.stats().messages == 1);        // m3
+    CHECK(rx.stats().orphans == 0);
+    CHECK(std::vector<uint8_t>(buf.begin() + 4096, buf.end()) == std::vector<uint8_t>(256, 0xEE));
+}
+
+// The receiver starts listening at m1's 3rd fragment: 7 orphans, then m2 whole
+static void orphans()
+{
+    const std::vector<uint8_t> m1(1000, 1), m2(500, 2);
+    const auto frames = fragments({&m1, &m2});
+    std::vector<uint8_t> buf(4096);
+    Reassembler rx(buf.data(), buf.size());
+    int got = 0;
+    for (size_t k = 2; k < frames.size(); ++k)
+        rx.onFrame(frames[k].id, frames[k].payload.data(), frames[k].length,
+                   [&](uint8_t, const uint8_t* m, uint32_t len) { got += len == 500 && m[0] == 2; });
+    CHECK(rx.stats().orphans == 7);
+    CHECK(rx.stats().messages == 1 && got == 1);
+    CHECK(rx.stats().incomplete == 0);
+}
+
+// ─────── numbers ───────
+static void cpuCost()
+{
+    for (size_t size : {4096u, 65536u}) {
+        std::vector<uint8_t> msg(size), buf(size);
+        for (size_t i = 0; i < size; ++i) msg[i] = static_cast<uint8_t>(i * 7 + 3);
+        MemStream s;
+        s.tx.reserve(size * 2);
+        SerialProtocol<128> tx(s), rx(s);
+        Fragmenter<128> frag;
+        Reassembler whole(buf.data(), buf.size());
+        const int reps = static_cast<int>(32 * 1024 * 1024 / size);
+        int got = 0;
+        Stopwatch sw;
+        for (int r = 0; r < reps; ++r) {
+            s.tx.clear();
+            frag.begin(1, msg.data(), static_cast<uint32_t>(size));
+            frag.pump(tx);
+            rx.processBytes(s.tx.data(), s.tx.size(), [&](const Frame& f) {
+                whole.onFrame(f.id, f.payload.data(), f.length, [&](uint8_t, const uint8_t*, uint32_t) { ++got; });
+            });
+        }
+        const double t = sw.seconds();
+        std::printf("CPU  %5zu B messages: %6.0f MB/s payload (%d/%d reassembled), %.1f us per message\n",
+                    size, reps * size / t / 1e6, got, reps, t / reps * 1e6);
+        CHECK(got == reps);
+    }
+}
+
+// Messages back to back over 115200 baud, the TX ring limited like Nexus'. @return wire seconds
+static double overWire(size_t size, double ber, int messages, int& delivered, uint32_t& incomplete)
+{
+    Clock::now() = 0;
+    MemStream a, line;
+    SerialProtocol<128, Crc16Table, 512> tx(a);
+    SerialProtocol<128> rx(line);
+    rx.setResync(true);
+    rx.setTimeout(0, 0, Clock::read);
+    std::vector<uint8_t> msg(size), buf(size);
+    for (size_t i = 0; i < size; ++i) msg[i] = static_cast<uint8_t>(i * 7 + 3);
+    Fragmenter<128> frag;
+    Reassembler whole(buf.data(), buf.size());
+    std::mt19937 rng(3);
+    std::bernoulli_distribution flip(ber);
+
+    delivered = 0;
+    int sent = 0;
+    double credit = 0;
+    size_t wireAt = 0;
+    uint8_t chunk[256];
+    while (sent < messages || frag.busy() || wireAt < a.tx.size() || tx.txPending()) {
+        if (!frag.busy() && sent < messages) {
+            frag.begin(0x42, msg.data(), static_cast<uint32_t>(size));
+            ++sent;
+        }
+        frag.pump(tx);
+        a.room = 64 - static_cast<int>(a.tx.size() - wireAt);     // 64 B UART FIFO, the rest waits in the ring
+        tx.poll();
+        size_t n = 0;
+        for (credit += 1.152; credit >= 1 && wireAt < a.tx.size() && n < sizeof chunk; credit -= 1) {
+            uint8_t c = a.tx[wireAt++];
+            for (int i = 0; i < 8; ++i)
+                if (flip(rng)) c ^= static_cast<uint8_t>(1 << i);
+            chunk[n++] = c;
+        }
+        if (credit > 1) credit = 1;
+        rx.processBytes(chunk, n, [&](const Frame& f) {
+            whole.onFrame(f.id, f.payload.data(), f.length, [&](uint8_t id, const uint8_t* m, uint32_t len) {
+                delivered += id == 0x42 && len == size && std::memcmp(m, msg.data(), size) == 0;
+            });
+        });
+        Clock::now() += 100;
+    }
+    CHECK(tx.stats().txOverflows == 0);
+    incomplete = whole.stats().incomplete;
+    return Clock::now() / 1e6;
+}
+
+int main()
+{
+    sizes();
+    droppedAndOversized();
+    orphans();
+
+    cpuCost();
+    for (size_t size : {4096u, 65536u}) {
+        for (double ber : {0.0, 1e-5}) {
+            const int n = size < 10000 ? 20 : 2;
+            int ok;
+            uint32_t incomplete;
+            const double s = overWire(size, ber, n, ok, incomplete);
+            std::printf("wire %5zu B x %2d, BER %.0e: %5.2f s, goodput %6.0f B/s (%.1f %% of the 11520 B/s line), "
+                        "%d/%d complete, %u incomplete\n", size, n, ber, s, ok * size / s,
+                        100.0 * ok * size / s / 11520, ok, n, incomplete);
+            if (ber == 0.0) CHECK(ok == n);
+        }
+    }
+    return testResult();
+}
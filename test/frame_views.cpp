@@ -0,0 +1,104 @@
+/* frame_views.cpp  ----------------------------------------------------------
+ * Reading packets out of frames without casts:
+ *
+ *   view<T>()   the right T for a frame of sizeof(T) bytes, whichever
+ *               parser path filled it (processByte() stores byte by byte,
+ *               processBytes() memcpy's runs), empty for any other length
+ *   as<T>()     the same copy when the length is already known
+ *   router      PacketRouter on superframe records: records start at any
+ *               offset, a packet behind a 1 B record is misaligned and must
+ *               still reach its handler intact; a wrong length is dropped
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <cstdint>
+
+#include <PacketRouter.hpp>
+#include <SerialProtocol.hpp>
+#include <Superframe.hpp>
+
+struct Mass { uint8_t id; float mass; };             // MassPacket's layout
+struct Wide { double t; uint32_t n; };               // the 8 B alignment SERIAL_PROTOCOL_PAYLOAD_ALIGN leaves room for
+
+using Parser = SerialProtocol<128>;
+
+static std::vector<Parser::Frame> frames(const std::vector<uint8_t>& wire, bool perByte)
+{
+    MemStream s;
+    Parser rx(s);
+    std::vector<Parser::Frame> out;
+    if (perByte) {
+        for (uint8_t b : wire)
+            if (rx.processByte(b)) out.push_back(rx.frame());
+    } else {
+        rx.processBytes(wire.data(), wire.size(), [&](const Parser::Frame& f) { out.push_back(f); });
+    }
+    return out;
+}
+
+static void views()
+{
+    MemStream s;
+    Parser tx(s);
+    const Mass m{5, 12.5f};
+    const Wide w{1719999999.125, 42};
+    tx.send(5, &m, sizeof m);
+    tx.send(9, &w, sizeof w);
+    tx.send(5, &m, sizeof m - 1);                   // truncated
+    for (bool perByte : {false, true}) {
+        const auto f = frames(s.tx, perByte);
+        CHECK(f.size() == 3);
+        if (f.size() != 3) continue;
+        const auto a = f[0].view<Mass>();
+        CHECK(a && a->id == 5 && a->mass == 12.5f);
+        CHECK(f[0].as<Mass>().mass == 12.5f);
+        const auto b = f[1].view<Wide>();
+        CHECK(b && b->t == 1719999999.125 && b->n == 42);
+        CHECK(!f[0].view<Wide>());                  // wrong type = wrong length
+        CHECK(!f[1].view<Mass>());
+        CHECK(!f[2].view<Mass>());                  // truncated
+    }
+}
+
+struct Ctx { uint32_t calls = 0; float mass = 0; double t = 0; };
+static void onMass(Ctx& c, const Mass& m) { ++c.calls; c.mass = m.mass; }
+static void onWide(Ctx& c, const Wide& w) { ++c.calls; c.t = w.t; }
+static void onBeat(Ctx& c, const uint8_t&) { ++c.calls; }
+
+using Router = PacketRouter<Ctx, 128, Route<5, Mass, onMass>, Route<9, Wide, onWide>, Route<2, uint8_t, onBeat>>;
+
+static void routerRecords()
+{
+    const uint8_t beat = 0;
+    const Mass m{5, -3.75f};
+    const Wide w{0.5, 7};
+    SuperframeBuilder<128> sf;
+    sf.add(2, &beat, 1);                            // Mass at offset 5, Wide behind it at 16 + 2
+    sf.add(5, &m, sizeof m);
+    sf.add(2, &beat, 1);
+    sf.add(9, &w, sizeof w);
+    sf.add(5, &m, sizeof m - 1);                    // wrong length
+    MemStream s;
+    Parser tx(s);
+    tx.send(sf);
+    const auto f = frames(s.tx, false);
+    CHECK(f.size() == 1);
+    if (f.size() != 1) return;
+
+    Ctx c;
+    int dispatched = 0, misaligned = 0;
+    forEachRecord(f[0].payload.data(), f[0].length, [&](uint8_t id, const uint8_t* p, uint8_t len) {
+        misaligned += (id == 5 || id == 9) && reinterpret_cast<std::uintptr_t>(p) % 4 != 0;
+        dispatched += Router::dispatch(c, id, p, len);
+    });
+    CHECK(misaligned >= 2);                         // the case being tested actually happened
+    CHECK(dispatched == 4 && c.calls == 4);
+    CHECK(c.mass == -3.75f && c.t == 0.5);
+}
+
+int main()
+{
+    views();
+    routerRecords();
+    return testResult();
+}
@@ -0,0 +1,103 @@
+/* host_test.hpp  ------------------------------------------------------------
+ * What every host test / bench in this directory shares:
+ *
+ *   CHECK(cond)    records a failure (file:line + the condition) and goes on,
+ *                  testResult() at the end of main() turns it into the exit
+ *                  code ctest looks at
+ *   MemStream      an Arduino Stream over two memory buffers: what the code
+ *                  under test writes lands in tx, what it reads comes from rx
+ *   FakeClock<N>   a clock the test moves by hand, for the ClockFn arguments
+ *                  (setTimeout(), setQuietTimeout(), TelemetryScheduler)
+ *   Stopwatch      wall time for the benchmark numbers
+ *
+ * Numbers are printed, never checked: a slow CI box must not fail a test.
+ * -------------------------------------------------------------------------*/
+#ifndef HOST_TEST_HPP
+#define HOST_TEST_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include <Arduino.h>              // avionics_debug/host/Arduino.h
+
+// ─────── checks ───────
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++testFailures();                                                         \
+        }                                                                             \
+    } while (0)
+
+inline int testResult()
+{
+    if (testFailures()) std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+    return testFailures() ? 1 : 0;
+}
+
+// ─────── Stream over memory ───────
+class MemStream : public Stream
+{
+public:
+    std::deque<uint8_t> rx;       // bytes the code under test will read
+    std::vector<uint8_t> tx;      // bytes it wrote
+    int room = 1 << 30;           // what availableForWrite() reports
+
+    int available() override { return static_cast<int>(rx.size()); }
+    int read() override
+    {
+        if (rx.empty()) return -1;
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+
+    size_t write(uint8_t b) override
+    {
+        tx.push_back(b);
+        return 1;
+    }
+    using Print::write;
+    int availableForWrite() override { return room; }
+};
+
+// ─────── hand-driven clock ───────
+// A different Tag per clock when one test needs two of them
+template<int Tag = 0>
+struct FakeClock
+{
+    static unsigned long& now()
+    {
+        static unsigned long t = 0;
+        return t;
+    }
+    static unsigned long read() { return now(); }
+};
+
+// ─────── wall time ───────
+class Stopwatch
+{
+public:
+    Stopwatch() : t0_(std::chrono::steady_clock::now()) {}
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count();
+    }
+    double nanos() const { return seconds() * 1e9; }
+
+private:
+    std::chrono::steady_clock::time_point t0_;
+};
+
+#endif // HOST_TEST_HPP
@@ -0,0 +1,159 @@
+/* mux_failover.cpp  ---------------------------------------------------------
+ * TransportMux with two StreamLinks (A preferred, B backup) on a fake clock.
+ * The host sends a heartbeat on both links every 10 ms:
+ *
+ *   quiet link   A goes silent for a second: TX moves to B within the quiet
+ *                timeout, and back to A once it talks again
+ *   lossy link   30% of A's frames are corrupted for two seconds: A never
+ *                goes quiet, the error rate has to move TX to B, and A gets
+ *                it back once its errors have faded out. No flapping.
+ *   mild noise   1% corrupted on A, under the margin: TX stays on A
+ *   stats()      read by a second thread while receive() runs: every
+ *                snapshot has to be one receive()'s, never a mix of two.
+ *                A third thread sends meanwhile (TX task): receive() reads
+ *                its counters, they must add up at the end (and it is a
+ *                clean run under -fsanitize=thread)
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include <TransportMux.hpp>
+
+using Clock = FakeClock<>;
+
+static const uint8_t kBeat = 1;
+
+// One heartbeat onto a link, its payload byte flipped (CRC failure) when corrupt
+static void beat(MemStream& link, bool corrupt)
+{
+    MemStream s;
+    SerialProtocol<128> host(s);
+    host.send(20, &kBeat, 1);
+    if (corrupt) s.tx[5] ^= 0xFF;
+    link.rx.insert(link.rx.end(), s.tx.begin(), s.tx.end());
+}
+
+struct Run {
+    long switchedAt = -1;   // first time TX left A
+    long backAt = -1;       // first time it came back after that
+    uint32_t failovers = 0;
+};
+
+// 10 ms ticks from 0 to endMs. silent(t) / lossPct(t): what link A does at time t
+template <typename Silent, typename Loss>
+static Run simulate(long endMs, Silent silent, Loss lossPct)
+{
+    Clock::now() = 0;
+    MemStream a, b;
+    StreamLink<128> la(a), lb(b);
+    TransportMux<128> mux;
+    mux.setQuietTimeout(200, Clock::read);
+    mux.setErrorFailover(50, 1000);
+    mux.add(la);
+    mux.add(lb);
+
+    std::mt19937 rng(3);
+    Run r;
+    for (long t = 0; t < endMs; t += 10) {
+        Clock::now() = static_cast<unsigned long>(t);
+        if (!silent(t)) beat(a, static_cast<int>(rng() % 100) < lossPct(t));
+        beat(b, false);
+        mux.receive([](const auto&) {});
+        if (r.switchedAt < 0 && mux.active() == 1) r.switchedAt = t;
+        if (r.switchedAt >= 0 && r.backAt < 0 && mux.active() == 0) r.backAt = t;
+    }
+    r.failovers = mux.failovers();
+    return r;
+}
+
+static void quietLink()
+{
+    const Run r = simulate(4000, [](long t) { return t >= 1000 && t < 2000; }, [](long) { return 0; });
+    std::printf("quiet link: A silent at 1000 ms, TX on B at %ld ms, back on A at %ld ms, %u failovers\n",
+                r.switchedAt, r.backAt, r.failovers);
+    CHECK(r.switchedAt > 1000 && r.switchedAt <= 1000 + 200 + 10);
+    CHECK(r.backAt >= 2000 && r.backAt <= 2010);
+    CHECK(r.failovers == 2);
+}
+
+static void lossyLink()
+{
+    const Run r = simulate(20000, [](long) { return false; }, [](long t) { return t >= 1000 && t < 3000 ? 30 : 0; });
+    std::printf("lossy link: A 30%% corrupted from 1000 to 3000 ms, TX on B at %ld ms, back on A at %ld ms, "
+                "%u failovers\n", r.switchedAt, r.backAt, r.failovers);
+    CHECK(r.switchedAt > 1000 && r.switchedAt < 1500);
+    CHECK(r.backAt > 3000);
+    CHECK(r.failovers == 2);
+}
+
+static void mildNoise()
+{
+    const Run r = simulate(10000, [](long) { return false; }, [](long) { return 1; });
+    std::printf("mild noise: A 1%% corrupted, %u failovers\n", r.failovers);
+    CHECK(r.switchedAt < 0 && r.failovers == 0);
+}
+
+// 200k heartbeats (8 bytes each) preloaded, the budget takes exactly 32 of them per receive():
+// in any consistent snapshot bytesIn == 8 * framesOk, and nothing ever goes backwards
+static void statsSnapshot()
+{
+    constexpr uint32_t kFrames = 200000;
+    MemStream a, b;
+    for (uint32_t k = 0; k < kFrames; ++k) beat(a, false);
+    StreamLink<128> la(a), lb(b);
+    TransportMux<128> mux;
+    mux.setQuietTimeout(200, Clock::read);
+    mux.setBudget(256);
+    mux.add(la);
+    mux.add(lb);
+
+    std::atomic<bool> done{false};
+    uint32_t reads = 0, torn = 0, backwards = 0;
+    std::thread reader([&] {
+        uint32_t last = 0;
+        while (!done.load()) {
+            const ProtocolStats s = mux.stats();
+            torn += s.bytesIn != 8 * s.framesOk;
+            backwards += s.framesOk < last;
+            last = s.framesOk;
+            ++reads;
+            if ((reads & 63) == 0) std::this_thread::yield();
+        }
+    });
+    constexpr uint32_t kSent = 20000;
+    std::thread tx([&] {
+        const uint8_t p[4] = {};
+        for (uint32_t k = 0; k < kSent; ++k) {
+            mux.send(2, p, sizeof p);
+            if ((k & 255) == 0) std::this_thread::yield();
+        }
+    });
+    size_t got = 0;
+    while (!a.rx.empty()) {
+        got += mux.receive([](const auto&) {});
+        if ((got & 1023) == 0) std::this_thread::yield();
+    }
+    tx.join();
+    done = true;
+    reader.join();
+    mux.receive([](const auto&) {});                    // publish the last TX counters
+
+    std::printf("stats(): %u reads from a second thread during %zu frames, %u torn, %u backwards\n",
+                reads, got, torn, backwards);
+    CHECK(got == kFrames);
+    CHECK(mux.stats().framesOk == kFrames);
+    CHECK(torn == 0 && backwards == 0);
+    CHECK(mux.active() == 0 && mux.stats().txBytes == kSent * 11);
+}
+
+int main()
+{
+    quietLink();
+    lossyLink();
+    mildNoise();
+    statsSnapshot();
+    return testResult();
+}
@@ -0,0 +1,83 @@
+/* packet_format.cpp  --------------------------------------------------------
+ * PacketFormatter (avionics_debug/packet_format.hpp) on LinkStats samples
+ * 500 ms apart on the ESP's clock:
+ *
+ *   - addRates(): per-second rates of the counters from the second sample
+ *     on, in text, CSV and JSON; a reboot (clock going back) starts over
+ *   - one CSV header per packet type, even when it comes on two IDs
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <packet_definition.hpp>
+#include <packet_fields.hpp>
+#include <packet_format.hpp>
+#include <packet_id.hpp>
+
+static size_t count(const std::string& s, const std::string& what)
+{
+    size_t n = 0;
+    for (size_t at = s.find(what); at != std::string::npos; at = s.find(what, at + 1)) ++n;
+    return n;
+}
+
+// Three samples 500 ms apart (5760 B and 100 frames each), then one after a reboot
+static std::string samples(OutFormat f)
+{
+    PacketFormatter fmt(f);
+    fmt.add(LinkStats_ID, LinkStats_desc);
+    CHECK(fmt.addRates(LinkStats_ID, "uptime_ms"));
+    CHECK(!fmt.addRates(LinkStats_ID, "bytes"));        // no such field
+    CHECK(!fmt.addRates(Heartbeat_ID, "uptime_ms"));    // not add()ed
+    std::string out;
+    LinkStats l{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        l.uptime_ms = 1000 + i * 500;
+        l.bytes_in += 5760;
+        l.frames_ok += 100;
+        fmt.packet(i, LinkStats_ID, reinterpret_cast<const uint8_t*>(&l), sizeof l, out);
+    }
+    l.uptime_ms = 10;
+    fmt.packet(3, LinkStats_ID, reinterpret_cast<const uint8_t*>(&l), sizeof l, out);
+    return out;
+}
+
+static void rates()
+{
+    const std::string text = samples(OutFormat::Text);
+    CHECK(count(text, " per_s { bytes_in=11520.0, frames_ok=200.0, crc_failures=0.0,") == 2);
+    CHECK(count(text, "\n") == 4);
+
+    const std::string csv = samples(OutFormat::Csv);
+    CHECK(csv.rfind("ts,frame_id,packet,uptime_ms,", 0) == 0);
+    CHECK(count(csv, ",tx_overflows,bytes_in/s,frames_ok/s,") == 1);
+    CHECK(count(csv, ",0,0,,,,,,,,\n") == 2);                               // first sample, after the reboot
+    CHECK(count(csv, ",11520.0,200.0,0.0,0.0,0.0,0.0,0.0,0.0\n") == 2);
+
+    const std::string json = samples(OutFormat::Json);
+    CHECK(count(json, ",\"per_s\":{\"bytes_in\":11520.0,\"frames_ok\":200.0,") == 2);
+    CHECK(count(json, "0.0}}\n") == 2);
+    if (testFailures()) std::printf("%s%s%s", text.c_str(), csv.c_str(), json.c_str());
+}
+
+static void oneHeaderPerType()
+{
+    PacketFormatter fmt(OutFormat::Csv);
+    fmt.add(MassDrill_ID, MassPacket_desc);
+    fmt.add(MassHD_ID, MassPacket_desc);
+    fmt.add(DustData_ID, DustData_desc);
+    std::string out;
+    const MassPacket m{};
+    const DustData d{};
+    for (uint8_t id : {MassDrill_ID, MassHD_ID, MassDrill_ID})
+        fmt.packet(0, id, reinterpret_cast<const uint8_t*>(&m), sizeof m, out);
+    fmt.packet(0, DustData_ID, reinterpret_cast<const uint8_t*>(&d), sizeof d, out);
+    CHECK(count(out, "ts,frame_id,packet") == 2);
+    CHECK(count(out, "\n") == 6);
+}
+
+int main()
+{
+    rates();
+    oneHeaderPerType();
+    return testResult();
+}
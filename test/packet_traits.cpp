@@ -0,0 +1,62 @@
+/* packet_traits.cpp  --------------------------------------------------------
+ * packet_traits.hpp, what Nexus::send<T>() relies on:
+ *
+ *   - every registered type maps to its packet_id.hpp ID, at compile time
+ *     (static_assert) for the one-ID packets
+ *   - MassPacket takes its ID from pkt.id at run time (drill or HD)
+ *   - send<T>() as Nexus does it (packetId(pkt), &pkt, sizeof(T)) puts the
+ *     right ID and the whole struct on the wire
+ * An unregistered type is compile_fail/send_unregistered.cpp.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <cstring>
+
+#include <SerialProtocol.hpp>
+#include <packet_traits.hpp>
+
+static_assert(packetId(DustData{}) == DustData_ID, "DustData");
+static_assert(packetId(FourInOne{}) == FourInOne_ID, "FourInOne");
+static_assert(packetId(Heartbeat{}) == Heartbeat_ID, "Heartbeat");
+static_assert(packetId(LinkStats{}) == LinkStats_ID, "LinkStats");
+static_assert(IsRegisteredPacket<MassPacket>::value && !IsRegisteredPacket<ServoRequest>::value, "registry");
+
+struct Wire {
+    MemStream s;
+    SerialProtocol<128> proto{s};
+
+    template <typename T>
+    void send(const T& pkt) { proto.send(packetId(pkt), &pkt, sizeof(T)); }     // = Nexus::send() -> publish()
+};
+
+// The frame on the wire has T's ID and exactly T's bytes
+template <typename T>
+static bool roundTrip(const T& pkt, uint8_t id)
+{
+    Wire w;
+    w.send(pkt);
+    int ok = 0;
+    SerialProtocol<128> rx(w.s);
+    rx.processBytes(w.s.tx.data(), w.s.tx.size(), [&](const auto& f) {
+        ok += f.id == id && f.length == sizeof(T) && std::memcmp(f.payload.data(), &pkt, sizeof(T)) == 0;
+    });
+    return ok == 1;
+}
+
+int main()
+{
+    DustData dust{};
+    dust.pm2_5_std = 35;
+    LinkStats ls{};
+    ls.frames_ok = 1234;
+    CHECK(roundTrip(dust, DustData_ID));
+    CHECK(roundTrip(FourInOne{}, FourInOne_ID));
+    CHECK(roundTrip(Heartbeat{}, Heartbeat_ID));
+    CHECK(roundTrip(ls, LinkStats_ID));
+
+    const MassPacket drill{MassDrill_ID, 1.5f}, hd{MassHD_ID, 2.5f};
+    CHECK(packetId(drill) == MassDrill_ID && packetId(hd) == MassHD_ID);
+    CHECK(roundTrip(drill, MassDrill_ID));
+    CHECK(roundTrip(hd, MassHD_ID));
+    return testResult();
+}
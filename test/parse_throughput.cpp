@@ -0,0 +1,88 @@
+/* parse_throughput.cpp  -----------------------------------------------------
+ * SerialProtocol RX throughput, processByte() one byte at a time against
+ * processBytes() on the chunks Nexus::receive reads (64 B), on the same
+ * capture of 200k frames:
+ *
+ *   - 8 B   (MassPacket-sized)
+ *   - 24 B  (DustData-sized)
+ *   - 127 B (a full MaxPayload 128 frame minus the ID)
+ *
+ * and both again with resync on (processBytes() then goes byte per byte
+ * too, see setResync()). Prints frames/s and MB/s of wire for each path;
+ * checks that both paths see every frame with the same IDs.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include <SerialProtocol.hpp>
+
+constexpr int kFrames = 200000;
+constexpr size_t kChunk = 64;
+
+using Parser = SerialProtocol<128>;
+
+static std::vector<uint8_t> capture(uint16_t payload)
+{
+    MemStream s;
+    Parser tx(s);
+    std::mt19937 rng(3);
+    uint8_t p[127];
+    for (int k = 0; k < kFrames; ++k) {
+        for (auto& b : p) b = static_cast<uint8_t>(rng());
+        tx.send(static_cast<uint8_t>(k), p, payload);
+    }
+    return s.tx;
+}
+
+struct Result { long frames; uint32_t idSum; double seconds; };
+
+static Result perByte(const std::vector<uint8_t>& wire, bool resync)
+{
+    MemStream s;
+    Parser rx(s);
+    rx.setResync(resync);
+    Result r{};
+    Stopwatch sw;
+    for (uint8_t b : wire)
+        if (rx.processByte(b)) {
+            ++r.frames;
+            r.idSum += rx.frame().id;
+        }
+    r.seconds = sw.seconds();
+    return r;
+}
+
+static Result bulk(const std::vector<uint8_t>& wire, bool resync)
+{
+    MemStream s;
+    Parser rx(s);
+    rx.setResync(resync);
+    Result r{};
+    Stopwatch sw;
+    for (size_t at = 0; at < wire.size(); at += kChunk)
+        rx.processBytes(wire.data() + at, std::min(kChunk, wire.size() - at), [&](const Parser::Frame& f) {
+            ++r.frames;
+            r.idSum += f.id;
+        });
+    r.seconds = sw.seconds();
+    return r;
+}
+
+int main()
+{
+    for (uint16_t payload : {8, 24, 127}) {
+        const auto wire = capture(payload);
+        for (bool resync : {false, true}) {
+            const Result a = perByte(wire, resync), b = bulk(wire, resync);
+            std::printf("%3u B payload, resync %-3s: processByte %6.2f M frames/s (%6.1f MB/s) | processBytes(%zu B) "
+                        "%6.2f M frames/s (%6.1f MB/s) | x%.2f\n", payload, resync ? "on" : "off",
+                        a.frames / a.seconds / 1e6, wire.size() / a.seconds / 1e6, kChunk, b.frames / b.seconds / 1e6,
+                        wire.size() / b.seconds / 1e6, a.seconds / b.seconds);
+            CHECK(a.frames == kFrames && b.frames == kFrames);
+            CHECK(a.idSum == b.idSum);
+        }
+    }
+    return testResult();
+}
@@ -0,0 +1,78 @@
+/* parser_byte_cost.cpp  -----------------------------------------------------
+ * SerialProtocol::processByte() cost per byte, by position in the frame.
+ * The CRC is accumulated byte by byte, so the last CRC byte must cost the
+ * same as any payload byte (no end-of-frame spike). That's what decides the
+ * worst case in an ISR.
+ *
+ * Every byte is timed on its own over 2000 frames of 127 B. Per position we
+ * keep the median, which is robust to the OS preempting us. The worst
+ * position is compared with the median byte and with what the old parser
+ * did on the last byte (one CRC over the whole payload).
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <algorithm>
+
+#include <SerialProtocol.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+static double median(std::vector<double>& v)
+{
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+int main()
+{
+    constexpr int kFrames = 2000;
+    constexpr size_t kPayload = 127;
+
+    MemStream s;
+    SerialProtocol<128> parser(s);
+    uint8_t payload[kPayload];
+    for (size_t i = 0; i < kPayload; ++i) payload[i] = static_cast<uint8_t>(i * 7);
+    for (int k = 0; k < kFrames; ++k) parser.send(5, payload, kPayload);
+    const size_t frameBytes = s.tx.size() / kFrames;        // 2 SOF + 2 len + id + payload + 2 CRC
+
+    // What now() itself costs, taken off every sample
+    std::vector<double> empty(100000);
+    for (auto& e : empty) {
+        auto t0 = Clock::now();
+        e = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    }
+    const double overhead = median(empty);
+
+    std::vector<std::vector<double>> byPosition(frameBytes, std::vector<double>(kFrames));
+    int frames = 0;
+    for (size_t i = 0; i < s.tx.size(); ++i) {
+        auto t0 = Clock::now();
+        frames += parser.processByte(s.tx[i]);
+        byPosition[i % frameBytes][i / frameBytes] =
+            std::chrono::duration<double, std::nano>(Clock::now() - t0).count() - overhead;
+    }
+    CHECK(frames == kFrames);
+
+    std::vector<double> med(frameBytes);
+    for (size_t p = 0; p < frameBytes; ++p) med[p] = median(byPosition[p]);
+    const size_t worst = static_cast<size_t>(std::max_element(med.begin(), med.end()) - med.begin());
+    std::vector<double> all(med);
+    const double typical = median(all);
+
+    // The old CrcHi state: one CRC over ID + payload on the last byte
+    std::vector<double> oldLast(kFrames);
+    volatile uint16_t sink = 0;
+    for (auto& t : oldLast) {
+        auto t0 = Clock::now();
+        sink = Crc16Table::update(Crc16Table::kInit, payload, kPayload);
+        t = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() - overhead;
+    }
+    (void)sink;
+
+    std::printf("processByte, median per position over %d frames of %zu B (timer overhead %.0f ns removed):\n",
+                kFrames, kPayload, overhead);
+    std::printf("  typical byte %.1f ns, worst position %zu/%zu %.1f ns, last CRC byte %.1f ns\n",
+                typical, worst, frameBytes - 1, med[worst], med[frameBytes - 1]);
+    std::printf("  (a CRC over the whole payload on the last byte, as before: %.1f ns)\n", median(oldLast));
+    return testResult();
+}
@@ -0,0 +1,105 @@
+/* parser_timeouts.cpp  ------------------------------------------------------
+ * SerialProtocol::setTimeout() on a fake clock:
+ *
+ *   cut frames     1000 frames at 115200 baud, every tenth cut in half and
+ *                  followed by a 100 ms silence: the 900 complete ones must
+ *                  all arrive and the 100 cut ones must be counted as
+ *                  timeouts, with and without resync
+ *   frame start    one buffer ends frame A and starts frame B, B finishes in
+ *                  the next buffer: B is timed from its own first byte, not
+ *                  from A's, so a whole-frame timeout doesn't drop it
+ *   slow frame     a frame that dribbles in slower than the whole-frame
+ *                  timeout is dropped
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <SerialProtocol.hpp>
+
+using Clock = FakeClock<>;
+
+static std::vector<uint8_t> encode(uint8_t id, size_t len)
+{
+    MemStream s;
+    SerialProtocol<128> tx(s);
+    std::vector<uint8_t> p(len, 0x11);
+    tx.send(id, p.data(), static_cast<uint16_t>(len));
+    return s.tx;
+}
+
+static void cutFrames(bool resync, bool bulk)
+{
+    MemStream s;
+    SerialProtocol<128> rx(s);
+    rx.setResync(resync);
+    rx.setTimeout(2000, 0, Clock::read);
+    const auto frame = encode(15, 24);
+    int got = 0;
+    for (int k = 0; k < 1000; ++k) {
+        const size_t n = (k % 10 == 0) ? frame.size() / 2 : frame.size();
+        if (bulk) {
+            Clock::now() += 87 * n;
+            got += static_cast<int>(rx.processBytes(frame.data(), n, [](const auto&) {}));
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                Clock::now() += 87;                     // one byte at 115200 baud
+                got += rx.processByte(frame[i]);
+            }
+        }
+        Clock::now() += (k % 10 == 0) ? 100000 : 500;
+    }
+    std::printf("cut frames, resync %-3s %-9s: %d/900 frames, %u timeouts\n",
+                resync ? "on" : "off", bulk ? "bulk" : "per byte", got, rx.stats().timeouts);
+    CHECK(got == 900);
+    CHECK(rx.stats().timeouts == 100);
+}
+
+static void frameStartMidBuffer(bool resync)
+{
+    MemStream s;
+    SerialProtocol<128> rx(s);
+    rx.setResync(resync);
+    rx.setTimeout(0, 5000, Clock::read);                // whole frame in 5 ms, no inter-byte limit
+    const auto a = encode(5, 8);
+    const auto b = encode(7, 8);
+
+    // t = 0: A, then a gap, t = 4.5 ms: the rest of A + the first half of B in one buffer
+    std::vector<uint8_t> first(a.begin(), a.begin() + 4);
+    std::vector<uint8_t> second(a.begin() + 4, a.end());
+    second.insert(second.end(), b.begin(), b.begin() + 6);
+    std::vector<uint8_t> third(b.begin() + 6, b.end());
+
+    std::vector<uint8_t> ids;
+    auto onFrame = [&](const auto& f) { ids.push_back(f.id); };
+    rx.processBytes(first.data(), first.size(), onFrame);
+    Clock::now() += 4500;
+    rx.processBytes(second.data(), second.size(), onFrame);
+    Clock::now() += 3000;                               // 7.5 ms after A started, 3 ms after B did
+    rx.processBytes(third.data(), third.size(), onFrame);
+    CHECK(ids.size() == 2 && ids[0] == 5 && ids[1] == 7);
+    CHECK(rx.stats().timeouts == 0);
+}
+
+static void slowFrame()
+{
+    MemStream s;
+    SerialProtocol<128> rx(s);
+    rx.setTimeout(0, 5000, Clock::read);
+    const auto f = encode(5, 24);
+    int got = 0;
+    for (uint8_t b : f) {
+        Clock::now() += 1000;                           // 31 bytes over 31 ms
+        got += rx.processByte(b);
+    }
+    CHECK(got == 0);
+    CHECK(rx.stats().timeouts >= 1);
+}
+
+int main()
+{
+    for (bool resync : {false, true})
+        for (bool bulk : {false, true}) cutFrames(resync, bulk);
+    frameStartMidBuffer(false);
+    frameStartMidBuffer(true);
+    slowFrame();
+    return testResult();
+}
@@ -0,0 +1,106 @@
+/* rtos_tasks.cpp  -----------------------------------------------------------
+ * Rtos.hpp on the host (std::thread): main.cpp's three-task split, with the
+ * sensor task doing a 100 ms tare every 50 samples.
+ *
+ * Checks (the functional part, timings depend on the box):
+ *   - every sample crosses the sensor -> TX queue once, in order
+ *   - receive() on an empty queue times out, send() on a full one with no
+ *     timeout fails, kForever waits for the other side
+ *   - rtos::shutdown() ends every task loop and the Task destructors join
+ * Prints the worst RX loop period (the tare must not show up in it, it did
+ * with the single loop()) and the queue hop latency.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <thread>
+
+#include <Rtos.hpp>
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct Sample { uint32_t seq; SteadyClock::time_point t; };
+
+static rtos::Queue<Sample, 16> samples;     // sensor -> TX
+static std::atomic<uint32_t> sent{0}, got{0}, outOfOrder{0};
+static std::atomic<bool> sensorDone{false};
+static double worstRxMs = 0, worstHopUs = 0, sumHopUs = 0;
+
+static void sensorLoop(void*)
+{
+    uint32_t n = 0;
+    while (rtos::running()) {
+        if (n % 50 == 49) rtos::delayMs(100);            // tare
+        if (samples.send({n, SteadyClock::now()}, 50)) ++n;
+        sent = n;
+        rtos::delayMs(5);
+    }
+    sensorDone = true;
+}
+
+static void txLoop(void*)
+{
+    Sample s;
+    uint32_t expect = 0;
+    while (!sensorDone || samples.size() > 0) {          // drain what the sensor sent before it stopped
+        if (!samples.receive(s, 10)) continue;
+        outOfOrder += s.seq != expect;
+        expect = s.seq + 1;
+        ++got;
+        const double us = std::chrono::duration<double, std::micro>(SteadyClock::now() - s.t).count();
+        sumHopUs += us;
+        if (us > worstHopUs) worstHopUs = us;
+    }
+}
+
+static void rxLoop(void*)
+{
+    auto last = SteadyClock::now();
+    while (rtos::running()) {
+        rtos::delayMs(1);
+        const auto now = SteadyClock::now();
+        const double ms = std::chrono::duration<double, std::milli>(now - last).count();
+        if (ms > worstRxMs) worstRxMs = ms;
+        last = now;
+    }
+}
+
+static void queueSemantics()
+{
+    rtos::Queue<int, 2> q;
+    int v = 0;
+    Stopwatch sw;
+    CHECK(!q.receive(v, 20));
+    CHECK(sw.seconds() >= 0.019);
+    CHECK(q.send(1) && q.send(2));
+    CHECK(!q.send(3));                                  // full, no wait
+    CHECK(q.size() == 2);
+
+    std::thread consumer([&] { rtos::delayMs(20); int x; q.receive(x); });
+    CHECK(q.send(3, rtos::kForever));                   // waits for the consumer
+    consumer.join();
+    CHECK(q.receive(v) && v == 2 && q.receive(v) && v == 3 && !q.receive(v));
+}
+
+int main()
+{
+    queueSemantics();
+
+    Stopwatch sw;
+    {
+        rtos::Task<4096> rx, tx, sensor;
+        //           name      fn          arg      prio  core
+        rx.start(    "rx",     rxLoop,     nullptr, 3,    0);
+        tx.start(    "tx",     txLoop,     nullptr, 2,    0);
+        sensor.start("sensor", sensorLoop, nullptr, 2,    1);
+        rtos::delayMs(2000);
+        rtos::shutdown();
+    }                                                   // joined here
+    std::printf("tasks, %.1f s: %u samples sent, %u received, worst RX loop period %.2f ms "
+                "(tare = 100 ms in the sensor task), queue hop mean %.1f us worst %.1f us\n",
+                sw.seconds(), sent.load(), got.load(), worstRxMs, got ? sumHopUs / got : 0.0, worstHopUs);
+    CHECK(sent > 100);
+    CHECK(got == sent);
+    CHECK(outOfOrder == 0);
+    CHECK(!rtos::running());
+    return testResult();
+}
@@ -0,0 +1,141 @@
+/* rx_budget.cpp  ------------------------------------------------------------
+ * A bounded receive() (TransportMux::setBudget(), as Nexus::receive() uses
+ * it) against a host flooding the UART with servo commands, in virtual time:
+ *
+ *   - the host sends 9 B commands back to back at 115200 baud
+ *   - every command handled costs the loop cost_us (servo driver, ...)
+ *   - the HX711 has a new sample every 12.5 ms, overwritten if loop() didn't
+ *     come around to read it in time
+ *
+ * Checks: with the budget Nexus uses (64 B) every HX711 sample is read, and
+ * at 500 us per command the commands still keep up with the line. Without a
+ * budget, at 2 ms per command, loop() never gets out of receive() and the
+ * samples are lost: that's what the budget is for.
+ * Then: several mass requests in one receive() all come out of the Change
+ * queue, in order, instead of only the first one.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <EventQueue.hpp>
+#include <TransportMux.hpp>
+
+constexpr uint64_t kByteUs = 87;            // 115200 8N1
+constexpr uint64_t kSampleUs = 12500;       // HX711 at 80 SPS
+constexpr uint64_t kRunUs = 2000000;
+
+static uint64_t nowUs;
+static unsigned long clockMs() { return static_cast<unsigned long>(nowUs / 1000); }
+
+// The UART: bytes the host has put on the line by nowUs
+class FloodedUart
+{
+public:
+    MemStream link;
+
+    void feed()
+    {
+        while (fedUs_ + kByteUs <= nowUs && fedUs_ < kRunUs) {     // the host stops after kRunUs
+            fedUs_ += kByteUs;
+            if (at_ == frame_.tx.size()) at_ = 0;
+            link.rx.push_back(frame_.tx[at_++]);
+        }
+    }
+
+    FloodedUart()
+    {
+        SerialProtocol<128> host(frame_);
+        const uint8_t servo[9] = {3};
+        host.send(3, servo, sizeof servo);
+    }
+
+private:
+    MemStream frame_;
+    size_t at_ = 0;
+    uint64_t fedUs_ = 0;
+};
+
+struct Result { size_t commands; int samples, read; double worstGapMs; size_t backlog; };
+
+static Result run(size_t budget, uint64_t costUs)
+{
+    nowUs = 0;
+    FloodedUart uart;
+    StreamLink<128> link(uart.link);
+    TransportMux<128> mux;
+    mux.setQuietTimeout(500, clockMs);
+    mux.setBudget(budget);
+    mux.add(link);
+
+    Result r{};
+    uint64_t nextSample = kSampleUs, lastRead = 0, worstGap = 0;
+    bool pending = false;
+    while (nowUs < kRunUs) {
+        uart.feed();
+        r.commands += mux.receive([&](const auto&) { nowUs += costUs; uart.feed(); });
+        while (nowUs >= nextSample) {           // a conversion nobody read is overwritten
+            ++r.samples;
+            pending = true;
+            nextSample += kSampleUs;
+        }
+        if (pending) {
+            ++r.read;
+            pending = false;
+            if (nowUs - lastRead > worstGap) worstGap = nowUs - lastRead;
+            lastRead = nowUs;
+        }
+        nowUs += 200;                           // the rest of loop()
+    }
+    r.worstGapMs = worstGap / 1000.0;
+    r.backlog = uart.link.rx.size();
+    std::printf("budget %10zu B, %4lu us/command: %5zu commands, HX711 %3d/%3d samples read, worst gap %6.1f ms, "
+                "backlog %zu B\n", budget, static_cast<unsigned long>(costUs), r.commands, r.read, r.samples,
+                r.worstGapMs, r.backlog);
+    return r;
+}
+
+struct Change { uint8_t id; bool tare; float scale; };    // as in Nexus.hpp
+
+static void changesInOneReceive()
+{
+    MemStream line, hostTx;
+    SerialProtocol<128> host(hostTx);
+    for (uint8_t k = 0; k < 5; ++k) {
+        const uint8_t servo[9] = {3};
+        host.send(3, servo, sizeof servo);
+        const uint8_t tare[2] = {1, k};          // a mass request, k tells them apart
+        host.send(static_cast<uint8_t>(k & 1 ? 7 : 5), tare, sizeof tare);
+    }
+    line.rx.assign(hostTx.tx.begin(), hostTx.tx.end());
+
+    StreamLink<128> link(line);
+    TransportMux<128> mux;
+    mux.add(link);
+    mux.setBudget(1024);
+    EventQueue<Change, 8> changes;
+    int servos = 0;
+    mux.receive([&](const auto& f) {
+        if (f.id == 3) ++servos;
+        else changes.push({f.id, f.payload[0] != 0, static_cast<float>(f.payload[1])});
+    });
+
+    CHECK(servos == 5);
+    CHECK(changes.size() == 5);
+    Change c;
+    for (int k = 0; k < 5; ++k) CHECK(changes.pop(c) && c.id == (k & 1 ? 7 : 5) && c.scale == k);
+    CHECK(changes.dropped() == 0);
+}
+
+int main()
+{
+    for (uint64_t cost : {500, 2000}) {
+        const Result unbounded = run(size_t(1) << 30, cost);
+        for (size_t budget : {256, 128}) run(budget, cost);
+        const Result nexus = run(64, cost);
+        CHECK(nexus.read == nexus.samples);
+        CHECK(nexus.worstGapMs < kSampleUs / 1000.0 * 2);
+        if (cost == 500) CHECK(nexus.backlog < 256);             // 500 us per 16 B command keeps up with the line
+        if (cost == 2000) CHECK(unbounded.read < unbounded.samples / 2);
+    }
+    changesInOneReceive();
+    return testResult();
+}
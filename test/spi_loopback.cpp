@@ -0,0 +1,124 @@
+/* spi_loopback.cpp  ---------------------------------------------------------
+ * SPISlaveProtocol over a mock SpiSlaveHal standing in for the Pi (master):
+ * the master replays 100k DustData-sized frames (Pi -> ESP) while the ESP
+ * answers with its own frames (ESP -> Pi). Bytes move one TxnSize
+ * transaction at a time, at a simulated 8 MHz clock with a 2 us gap
+ * between transactions.
+ *
+ * Checks: every frame in both directions arrives once, in order, intact.
+ * Prints the simulated frame rate each way.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <cstring>
+
+#include <SPISlaveProtocol.hpp>
+
+// The master: clocks whatever transaction the slave queued, RX from a capture, TX collected
+class MockMaster : public SpiSlaveHal
+{
+public:
+    std::vector<uint8_t> toSlave;       // what the master sends
+    size_t sent = 0;
+    std::vector<uint8_t> fromSlave;     // what it got back
+    double simSeconds = 0;
+
+    bool begin(size_t) override { return true; }
+    bool queue(uint8_t slot, const uint8_t* tx, uint8_t* rx, size_t len) override
+    {
+        queued_.push_back({slot, tx, rx, len});
+        return true;
+    }
+    bool finished(uint8_t* slot, size_t* received) override
+    {
+        if (done_.empty()) return false;
+        *slot = done_.front().slot;
+        *received = done_.front().len;
+        done_.pop_front();
+        return true;
+    }
+
+    // One full transaction, if the slave has one queued
+    bool clock()
+    {
+        if (queued_.empty()) return false;
+        Txn t = queued_.front();
+        queued_.pop_front();
+        for (size_t i = 0; i < t.len; ++i) {
+            t.rx[i] = sent < toSlave.size() ? toSlave[sent++] : 0x00;
+            fromSlave.push_back(t.tx[i]);
+        }
+        simSeconds += t.len * 8 / 8e6 + 2e-6;
+        done_.push_back(t);
+        return true;
+    }
+
+private:
+    struct Txn { uint8_t slot; const uint8_t* tx; uint8_t* rx; size_t len; };
+    std::deque<Txn> queued_;
+    std::deque<Txn> done_;
+};
+
+constexpr uint32_t kFrames = 100000;
+constexpr uint16_t kLen = 24;
+
+static void fill(uint8_t* p, uint32_t k)
+{
+    std::memcpy(p, &k, 4);
+    for (uint16_t i = 4; i < kLen; ++i) p[i] = static_cast<uint8_t>(k + i);
+}
+
+static bool intact(const uint8_t* p, uint16_t len, uint32_t k)
+{
+    uint8_t want[kLen];
+    fill(want, k);
+    return len == kLen && std::memcmp(p, want, kLen) == 0;
+}
+
+int main()
+{
+    MockMaster master;
+    SPISlaveProtocol<128, 512> spi(master);
+    CHECK(spi.begin());
+
+    // Pi -> ESP capture
+    MemStream m;
+    SerialProtocol<128> enc(m);
+    uint8_t p[kLen];
+    for (uint32_t k = 0; k < kFrames; ++k) {
+        fill(p, k);
+        enc.send(15, p, kLen);
+    }
+    master.toSlave = m.tx;
+
+    uint32_t rx = 0, rxBad = 0, tx = 0;
+    while (master.sent < master.toSlave.size() || tx < kFrames || spi.txPending() > 0) {
+        if (!master.clock()) break;
+        spi.poll([&](const auto& f) { rxBad += !(f.id == 15 && intact(f.payload.data(), f.length, rx)); ++rx; });
+        while (tx < kFrames && spi.canQueue(kLen)) {       // the ESP answers as fast as its ring allows
+            fill(p, tx);
+            if (!spi.send(5, p, kLen)) break;
+            ++tx;
+        }
+    }
+    for (int i = 0; i < 4; ++i) {                           // the last transactions in flight
+        master.clock();
+        spi.poll([&](const auto&) { ++rx; });
+    }
+
+    // ESP -> Pi, decoded the way the Pi does
+    SerialProtocol<128> dec(m);
+    uint32_t back = 0, backBad = 0;
+    dec.processBytes(master.fromSlave.data(), master.fromSlave.size(), [&](const auto& f) {
+        backBad += !(f.id == 5 && intact(f.payload.data(), f.length, back));
+        ++back;
+    });
+
+    std::printf("SPI loopback, 8 MHz, 64 B transactions: Pi->ESP %u/%u frames (%u bad), ESP->Pi %u/%u (%u bad), "
+                "%.3f s simulated = %.0f frames/s each way\n",
+                rx, kFrames, rxBad, back, kFrames, backBad, master.simSeconds, rx / master.simSeconds);
+    CHECK(rx == kFrames && rxBad == 0);
+    CHECK(back == kFrames && backBad == 0);
+    CHECK(spi.stats().crcFailures == 0);
+    return testResult();
+}
@@ -0,0 +1,173 @@
+/* spsc_stress.cpp  ----------------------------------------------------------
+ * FrameQueue.hpp and ByteRing.hpp under two real threads, one producer and
+ * one consumer, each ring kept small so it wraps and fills all the time:
+ *
+ *   FrameQueue   a parser thread pushes frames straight from
+ *                processBytes() (and through back()/commit()), a consumer
+ *                thread pops them. Every frame has to come out exactly once,
+ *                in order, intact, unless it was counted in dropped().
+ *   ByteRing     variable-size put()/commit() records against peek()/
+ *                consume(). The byte stream must come out exactly as written,
+ *                and whatever size() says is published must always end on a
+ *                record boundary (commit() is all or nothing).
+ *
+ * Run it under -fsanitize=thread as well when touching either ring.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <ByteRing.hpp>
+#include <FrameQueue.hpp>
+#include <SerialProtocol.hpp>
+
+using Frame = SerialProtocol<128>::Frame;
+
+// Parsed by the producer thread, popped (or peeked in place) by the consumer
+static void frameQueueStress(bool zeroCopy)
+{
+    constexpr uint32_t kFrames = 300000;
+    MemStream s;
+    SerialProtocol<128> enc(s);
+    for (uint32_t k = 0; k < kFrames; ++k) {
+        uint8_t p[12];
+        std::memcpy(p, &k, 4);
+        std::memset(p + 4, static_cast<int>(k & 0xFF), sizeof p - 4);
+        enc.send(static_cast<uint8_t>(k), p, 4 + k % 9);
+    }
+
+    FrameQueue<Frame, 16> q;
+    SerialProtocol<128> rx(s);
+    std::atomic<bool> done{false};
+    Stopwatch sw;
+
+    std::thread producer([&] {
+        for (size_t i = 0; i < s.tx.size(); i += 37) {
+            const size_t n = std::min<size_t>(37, s.tx.size() - i);
+            while (q.capacity() - q.size() < 4) std::this_thread::yield();     // lossless: wait for room
+            if (zeroCopy) {
+                rx.processBytes(s.tx.data() + i, n, [&](const Frame& f) {
+                    Frame* slot = q.back();
+                    if (!slot) return;
+                    slot->id = f.id;
+                    slot->length = f.length;
+                    std::memcpy(slot->payload.data(), f.payload.data(), f.length);
+                    q.commit();
+                });
+            } else {
+                rx.processBytes(s.tx.data() + i, n, q);
+            }
+        }
+        done = true;
+    });
+
+    uint32_t expect = 0, bad = 0;
+    std::thread consumer([&] {
+        while (true) {
+            const Frame* f = q.front();
+            if (!f) {
+                if (done && q.empty()) break;
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t v;
+            std::memcpy(&v, f->payload.data(), 4);
+            bool ok = v == expect && f->id == static_cast<uint8_t>(expect) && f->length == 4 + expect % 9;
+            for (uint16_t i = 4; ok && i < f->length; ++i) ok = f->payload[i] == static_cast<uint8_t>(expect);
+            bad += !ok;
+            ++expect;
+            q.release();
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    CHECK(q.dropped() == 0);
+    CHECK(expect == kFrames);
+    CHECK(bad == 0);
+    std::printf("FrameQueue<16>%s: %u/%u frames in order, %u corrupted, %u dropped, %.0f frames/s\n",
+                zeroCopy ? " back()/commit()" : " push()", expect, kFrames, bad, q.dropped(), expect / sw.seconds());
+}
+
+// Records of 2..256 bytes through a 512 B ring, never half published
+static void byteRingStress()
+{
+    constexpr uint32_t kRecords = 200000;
+    static ByteRing<512> ring;
+    std::atomic<bool> done{false};
+    Stopwatch sw;
+
+    // Record k = length byte L (1..255) followed by L bytes of (k + i)
+    std::thread producer([&] {
+        uint8_t rec[256];
+        for (uint32_t k = 0; k < kRecords; ++k) {
+            const uint8_t len = static_cast<uint8_t>(1 + (k * 37) % 255);
+            rec[0] = len;
+            for (uint8_t i = 0; i < len; ++i) rec[1 + i] = static_cast<uint8_t>(k + i);
+            while (ring.room() < static_cast<size_t>(len) + 1) std::this_thread::yield();
+            ring.put(rec[0]);                       // the two put() flavours, one commit
+            ring.put(rec + 1, len);
+            ring.commit();
+        }
+        done = true;
+    });
+
+    uint32_t records = 0, bad = 0, torn = 0;
+    std::thread consumer([&] {
+        std::vector<uint8_t> chunk;
+        while (true) {
+            // Everything published so far, and only that: it has to end on a record boundary
+            const size_t avail = ring.size();
+            if (avail == 0) {
+                if (done && ring.empty()) break;
+                std::this_thread::yield();
+                continue;
+            }
+            chunk.clear();
+            for (size_t left = avail; left > 0;) {      // two pieces when it wraps
+                const uint8_t* p;
+                const size_t n = std::min(ring.peek(&p), left);
+                chunk.insert(chunk.end(), p, p + n);
+                ring.consume(n);
+                left -= n;
+            }
+            size_t at = 0;
+            while (at < chunk.size() && at + 1 + chunk[at] <= chunk.size()) {
+                const uint8_t len = chunk[at];
+                bool ok = len == static_cast<uint8_t>(1 + (records * 37) % 255);
+                for (uint8_t i = 0; ok && i < len; ++i) ok = chunk[at + 1 + i] == static_cast<uint8_t>(records + i);
+                bad += !ok;
+                ++records;
+                at += 1 + len;
+            }
+            if (at != chunk.size()) { ++torn; break; }  // half a record was visible
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    CHECK(records == kRecords);
+    CHECK(bad == 0);
+    CHECK(torn == 0);
+    std::printf("ByteRing<512>: %u/%u records, %u corrupted, %u torn, %.1f MB/s\n",
+                records, kRecords, bad, torn, kRecords * 129.0 / sw.seconds() / 1e6);
+}
+
+int main()
+{
+    frameQueueStress(false);
+    frameQueueStress(true);
+    byteRingStress();
+
+    // A full queue drops the newest frame and counts it, never blocks
+    FrameQueue<Frame, 4> q;
+    Frame f{};
+    for (int i = 0; i < 6; ++i) { f.id = static_cast<uint8_t>(i); q.push(f); }
+    CHECK(q.size() == 4);
+    CHECK(q.dropped() == 2);
+    CHECK(q.back() == nullptr && q.dropped() == 3);
+    CHECK(q.pop(f) && f.id == 0);
+    return testResult();
+}
@@ -0,0 +1,115 @@
+/* telemetry_scheduler.cpp  --------------------------------------------------
+ * TelemetryScheduler on a fake clock, ticked every millisecond:
+ *
+ *   main.cpp's table   10 s: every stream runs on its slot (zero jitter),
+ *                      the right number of times, never two in one tick
+ *   blocking call      the loop stalls for 1.2 s: no catch-up burst, the
+ *                      missed periods are counted as overruns, back on the
+ *                      phase grid afterwards
+ *   same phase         three streams due on the same ms: one per tick, most
+ *                      important first
+ *   millis() wrap      the clock wraps mid-run, nothing notices
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <TelemetryScheduler.hpp>
+
+using Clock = FakeClock<>;
+
+static uint32_t lastRun[4];
+static int order[4], runs;
+static void s0() { lastRun[0] = static_cast<uint32_t>(Clock::now()); order[0] = runs++; }
+static void s1() { lastRun[1] = static_cast<uint32_t>(Clock::now()); order[1] = runs++; }
+static void s2() { lastRun[2] = static_cast<uint32_t>(Clock::now()); order[2] = runs++; }
+static void s3() { lastRun[3] = static_cast<uint32_t>(Clock::now()); order[3] = runs++; }
+
+// Same periods / phases as the telemetry table in avionics_stack/src/main.cpp
+static const TelemetryStream kTable[] = {
+    {"heartbeat",  500,  0,   0, s0},
+    {"mass",       1000, 125, 1, s1},
+    {"dust",       1000, 375, 2, s2},
+    {"link_stats", 1000, 625, 3, s3},
+};
+
+// tick() once per ms from start to start + ms, skipping [stallAt, stallAt + stallMs). @return most streams in one tick
+template <std::size_t N>
+static int drive(TelemetryScheduler<N>& s, unsigned long start, unsigned long ms,
+                 unsigned long stallAt = ~0ul, unsigned long stallMs = 0)
+{
+    int most = 0;
+    for (unsigned long t = 0; t < ms; ++t) {
+        if (t == stallAt) t += stallMs;
+        Clock::now() = start + t;
+        const int ran = s.tick();
+        if (ran > most) most = ran;
+    }
+    return most;
+}
+
+static void steady(unsigned long start)
+{
+    Clock::now() = start;
+    TelemetryScheduler<4> s(kTable, 1, Clock::read);
+    s.start();
+    const int most = drive(s, start, 10000);
+    CHECK(most == 1);
+    CHECK(s.stats(0).runs == 20);
+    for (std::size_t i = 1; i < 4; ++i) CHECK(s.stats(i).runs == 10);
+    for (std::size_t i = 0; i < 4; ++i) CHECK(s.stats(i).maxJitterMs == 0 && s.stats(i).overruns == 0);
+    CHECK(lastRun[3] == static_cast<uint32_t>(start + 9625));
+}
+
+static void blockingCall()
+{
+    Clock::now() = 0;
+    TelemetryScheduler<4> s(kTable, 1, Clock::read);
+    s.start();
+    const int most = drive(s, 0, 4000, 1500, 1200);     // nothing ticks from 1500 to 2700 ms
+    std::printf("1.2 s stall: at most %d stream(s) per tick\n", most);
+    for (std::size_t i = 0; i < 4; ++i) {
+        const StreamStats& st = s.stats(i);
+        std::printf("  %-10s runs %2u  overruns %u  max jitter %3u ms  mean %.1f ms\n", kTable[i].name, st.runs,
+                    st.overruns, st.maxJitterMs, st.runs ? static_cast<double>(st.totalJitterMs) / st.runs : 0.0);
+    }
+    CHECK(most == 1);
+    // heartbeat: 0, 500, 1000, then slot 1500 runs at 2700 (2000 and 2500 skipped), then 3000, 3500
+    CHECK(s.stats(0).overruns == 2);
+    CHECK(s.stats(0).runs == 6);
+    // the others run their pending slot (2125 / 2375 / 1625) late once, one per ms in priority order
+    CHECK(s.stats(1).maxJitterMs == 2701 - 2125 && s.stats(2).maxJitterMs == 2702 - 2375);
+    CHECK(s.stats(3).maxJitterMs == 2703 - 1625 && s.stats(3).overruns == 1);
+    CHECK(lastRun[3] == 3625);                            // back on the grid
+}
+
+static void samePhase()
+{
+    static const TelemetryStream same[] = {
+        {"z", 100, 0, 2, s2},
+        {"x", 100, 0, 0, s0},
+        {"y", 100, 0, 1, s1},
+    };
+    Clock::now() = 0;
+    TelemetryScheduler<3> s(same, 1, Clock::read);
+    s.start();
+    runs = 0;
+    Clock::now() = 0;
+    s.tick();
+    Clock::now() = 1;
+    s.tick();
+    Clock::now() = 2;
+    s.tick();
+    CHECK(order[0] == 0 && order[1] == 1 && order[2] == 2);
+    const int most = drive(s, 3, 997);
+    CHECK(most == 1);
+    CHECK(s.stats(0).maxJitterMs == 2 && s.stats(1).maxJitterMs == 0 && s.stats(2).maxJitterMs == 1);
+    CHECK(s.stats(0).runs == 10 && s.stats(0).overruns == 0);
+}
+
+int main()
+{
+    steady(0);
+    steady(0xFFFFFFFFul - 3000);          // millis() wraps 3 s in
+    blockingCall();
+    samePhase();
+    return testResult();
+}
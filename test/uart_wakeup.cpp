@@ -0,0 +1,120 @@
+/* uart_wakeup.cpp  ----------------------------------------------------------
+ * PtyUartPort + UartLink, the host stand-in for the ESP's event-driven UART:
+ * an RX thread owns the link, the test writes frames into the other end of
+ * the pseudo-terminal like the Raspberry Pi would.
+ *
+ *   waitRx   the RX thread sleeps in waitRx(100) between frames (NEXUS_UART_EVENTS)
+ *   polled   it checks available() every 1 ms instead (Arduino Serial loop)
+ *
+ * For each: CPU burnt by the RX thread during 1 s with nothing on the line,
+ * then 200 frames 5 ms apart, latency from write() to the frame coming out of
+ * the parser (mean / p99 / worst).
+ *
+ * Checks: every frame arrives, and waitRx() costs (next to) no CPU while the
+ * line is idle. Latencies depend on the box and are only printed.
+ * -------------------------------------------------------------------------*/
+#include "host_test.hpp"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <TransportMux.hpp>
+
+using Steady = std::chrono::steady_clock;
+
+static double cpuSeconds()
+{
+    rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return u.ru_utime.tv_sec + u.ru_stime.tv_sec + (u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e6;
+}
+
+struct Rx {
+    std::mutex m;
+    std::vector<double> latencyUs;
+    uint32_t frames = 0;
+};
+
+static void onFrame(void* ctx, const ProtocolFrame<128>& f)
+{
+    Rx& rx = *static_cast<Rx*>(ctx);
+    int64_t sent;
+    std::memcpy(&sent, f.payload.data(), sizeof sent);
+    const int64_t now = Steady::now().time_since_epoch().count();
+    std::lock_guard<std::mutex> lock(rx.m);
+    rx.latencyUs.push_back((now - sent) / 1000.0);
+    ++rx.frames;
+}
+
+struct Result { double idleCpu, meanUs, p99Us, worstUs; uint32_t frames; };
+
+static Result run(bool events)
+{
+    PtyUartPort port;
+    Result r{};
+    if (!port.begin()) return r;
+    const int pi = open(port.slaveName(), O_RDWR | O_NOCTTY);
+    UartLink<128> link(port);
+    Rx rx;
+    std::atomic<bool> stop{false};
+    std::thread task([&] {
+        while (!stop.load()) {
+            if (events) {
+                link.waitRx(100);
+            } else {
+                while (!stop.load() && port.available() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            link.pump(1024, onFrame, &rx);
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const double c0 = cpuSeconds();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    r.idleCpu = cpuSeconds() - c0;
+
+    constexpr int kFrames = 200;
+    for (int k = 0; k < kFrames; ++k) {
+        MemStream s;
+        SerialProtocol<128> enc(s);
+        const int64_t now = Steady::now().time_since_epoch().count();
+        enc.send(1, &now, sizeof now);
+        const ssize_t n = write(pi, s.tx.data(), s.tx.size());
+        (void)n;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stop = true;
+    task.join();
+    close(pi);
+
+    std::sort(rx.latencyUs.begin(), rx.latencyUs.end());
+    r.frames = rx.frames;
+    if (!rx.latencyUs.empty()) {
+        double sum = 0;
+        for (double l : rx.latencyUs) sum += l;
+        r.meanUs = sum / rx.latencyUs.size();
+        r.p99Us = rx.latencyUs[rx.latencyUs.size() * 99 / 100];
+        r.worstUs = rx.latencyUs.back();
+    }
+    std::printf("%-6s: idle 1 s: %.3f s CPU | %u/%d frames, write -> parsed mean %.0f us, p99 %.0f us, worst %.0f us\n",
+                events ? "waitRx" : "polled", r.idleCpu, r.frames, kFrames, r.meanUs, r.p99Us, r.worstUs);
+    CHECK(r.frames == kFrames);
+    return r;
+}
+
+int main()
+{
+    const Result waited = run(true);
+    run(false);
+    CHECK(waited.idleCpu < 0.05);
+    return testResult();
+}